@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "carl/actor.h"
+#include "carl/payload.h"
+#include "carl/propagation_engine.h"
+#include "carl/scheduler.h"
+#include "carl/signal.h"
+#include "carl/stream.h"
+#include "carl/task.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+template <typename T>
+void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Raw latency samples in nanoseconds. Percentiles are exact; every sample
+// includes one clock read of overhead.
+class Histogram {
+public:
+    void resize(std::size_t count) {
+        samples_.assign(count, 0);
+    }
+
+    std::uint64_t& operator[](std::size_t index) {
+        return samples_[index];
+    }
+
+    void record(std::uint64_t ns) {
+        samples_.push_back(ns);
+    }
+
+    std::size_t count() const noexcept {
+        return samples_.size();
+    }
+
+    std::uint64_t percentile(double p) {
+        if (samples_.empty()) {
+            return 0;
+        }
+        const auto rank = static_cast<std::size_t>(p * static_cast<double>(samples_.size() - 1));
+        std::nth_element(samples_.begin(), samples_.begin() + rank, samples_.end());
+        return samples_[rank];
+    }
+
+    std::uint64_t max() const {
+        return samples_.empty() ? 0 : *std::max_element(samples_.begin(), samples_.end());
+    }
+
+private:
+    std::vector<std::uint64_t> samples_{};
+};
+
+struct Result {
+    std::string name;
+    std::uint64_t ops{0};
+    double seconds{0.0};
+    Histogram latency{};
+};
+
+struct Config {
+    std::size_t workers{std::thread::hardware_concurrency()};
+    // Operations per case before the per-case weight is applied.
+    std::size_t ops{200000};
+    std::string filter{};
+    std::string output{};
+};
+
+std::size_t scaled(const Config& config, std::size_t divisor) {
+    return std::max<std::size_t>(config.ops / divisor, 10);
+}
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+Result bench_emit_fanout(const Config& config, std::size_t subscribers) {
+    Result result{"stream_emit_fanout/" + std::to_string(subscribers)};
+    carl::Stream<int> stream;
+    std::vector<carl::Subscription> subscriptions;
+    long long sink = 0;
+    for (std::size_t i = 0; i < subscribers; ++i) {
+        subscriptions.push_back(stream.subscribe([&sink](const int& value) { sink += value; }));
+    }
+
+    result.ops = scaled(config, std::max<std::size_t>(subscribers / 10, 1));
+    result.latency.resize(result.ops);
+    const auto start = Clock::now();
+    for (std::uint64_t i = 0; i < result.ops; ++i) {
+        const std::uint64_t sent = now_ns();
+        stream.emit(static_cast<int>(i));
+        result.latency[i] = now_ns() - sent;
+    }
+    result.seconds = seconds_since(start);
+    do_not_optimize(sink);
+    return result;
+}
+
+Result bench_map_chain(const Config& config, std::size_t depth) {
+    Result result{"stream_map_chain/" + std::to_string(depth)};
+    carl::Stream<int> source;
+    std::vector<carl::Stream<int>> stages;
+    stages.reserve(depth);
+    carl::Stream<int>* tail = &source;
+    for (std::size_t i = 0; i < depth; ++i) {
+        stages.push_back(carl::stream_map(*tail, [](int value) { return value + 1; }));
+        tail = &stages.back();
+    }
+    long long sink = 0;
+    auto subscription = tail->subscribe([&sink](const int& value) { sink += value; });
+
+    result.ops = scaled(config, std::max<std::size_t>(depth / 4, 1));
+    result.latency.resize(result.ops);
+    const auto start = Clock::now();
+    for (std::uint64_t i = 0; i < result.ops; ++i) {
+        const std::uint64_t sent = now_ns();
+        source.emit(static_cast<int>(i));
+        result.latency[i] = now_ns() - sent;
+    }
+    result.seconds = seconds_since(start);
+    do_not_optimize(sink);
+    return result;
+}
+
+// source -> (left, right) -> joined, updated with a synchronous set().
+Result bench_combine_diamond(const Config& config) {
+    Result result{"signal_combine_diamond"};
+    carl::Signal<int> source(0);
+    auto left = carl::signal_map(source, [](int value) { return value + 1; });
+    auto right = carl::signal_map(source, [](int value) { return value * 2; });
+    auto joined = carl::signal_combine(left, right, [](int a, int b) { return a + b; });
+    long long sink = 0;
+    auto subscription = joined.subscribe([&sink](const int& value) { sink += value; });
+
+    result.ops = scaled(config, 1);
+    result.latency.resize(result.ops);
+    const auto start = Clock::now();
+    for (std::uint64_t i = 0; i < result.ops; ++i) {
+        const std::uint64_t sent = now_ns();
+        source.set(static_cast<int>(i + 1));
+        result.latency[i] = now_ns() - sent;
+    }
+    result.seconds = seconds_since(start);
+    do_not_optimize(sink);
+    return result;
+}
+
+// The same diamond through the glitch-free PropagationEngine; latency is
+// set() until the scheduler is quiescent again.
+Result bench_engine_diamond(const Config& config) {
+    Result result{"engine_diamond"};
+    carl::Scheduler scheduler(config.workers);
+    carl::PropagationEngine engine(scheduler);
+    carl::Signal<int> source(0);
+    auto left = carl::signal_map(source, [](int value) { return value + 1; });
+    auto right = carl::signal_map(source, [](int value) { return value * 2; });
+    auto joined = carl::signal_combine(left, right, [](int a, int b) { return a + b; });
+    std::atomic<long long> sink{0};
+    auto subscription = joined.subscribe([&sink](const int& value) { sink.fetch_add(value); });
+
+    result.ops = scaled(config, 20);
+    result.latency.resize(result.ops);
+    const auto start = Clock::now();
+    for (std::uint64_t i = 0; i < result.ops; ++i) {
+        const std::uint64_t sent = now_ns();
+        engine.set(source, static_cast<int>(i + 1));
+        scheduler.run();
+        result.latency[i] = now_ns() - sent;
+    }
+    result.seconds = seconds_since(start);
+    return result;
+}
+
+// N reader threads call value() while the main thread keeps setting the
+// signal; latency is one read.
+Result bench_signal_read(const Config& config, std::size_t readers) {
+    Result result{"signal_read_contention/" + std::to_string(readers)};
+    carl::Signal<long long> signal(0);
+    const std::size_t per_reader = scaled(config, readers);
+    result.ops = per_reader * readers;
+    result.latency.resize(result.ops);
+    std::atomic<std::size_t> finished{0};
+    const auto start = Clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t r = 0; r < readers; ++r) {
+            threads.emplace_back([&signal, &finished, samples = &result.latency[r * per_reader], per_reader]() {
+                for (std::size_t i = 0; i < per_reader; ++i) {
+                    const std::uint64_t begin = now_ns();
+                    do_not_optimize(signal.value());
+                    samples[i] = now_ns() - begin;
+                }
+                finished.fetch_add(1);
+            });
+        }
+        for (long long value = 1; finished.load() < readers; ++value) {
+            signal.set(value);
+        }
+    }
+    result.seconds = seconds_since(start);
+    return result;
+}
+
+// N producer threads post into one actor; latency is post to handler.
+Result bench_actor_post(const Config& config, std::size_t producers) {
+    Result result{"actor_post_contention/" + std::to_string(producers)};
+    carl::Scheduler scheduler(config.workers);
+    carl::Actor actor(scheduler);
+    scheduler.spawn(actor.run());
+
+    const std::size_t per_producer = scaled(config, producers);
+    result.ops = per_producer * producers;
+    // The actor runs one message at a time, so the handler can append.
+    Histogram& latency = result.latency;
+    const auto start = Clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (std::size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&actor, &latency, per_producer]() {
+                for (std::size_t i = 0; i < per_producer; ++i) {
+                    const std::uint64_t sent = now_ns();
+                    actor.post([&latency, sent]() { latency.record(now_ns() - sent); });
+                }
+            });
+        }
+    }
+    scheduler.run();
+    result.seconds = seconds_since(start);
+    actor.stop();
+    scheduler.run();
+    return result;
+}
+
+// 64 KiB frames fanned out to 20 actors, either copied into every mailbox
+// or wrapped once by stream_share. Latency is emit until all have run.
+Result bench_frame_fanout(const Config& config, bool shared) {
+    constexpr std::size_t actor_count = 20;
+    Result result{std::string("actor_frame_fanout/") + (shared ? "shared" : "copy")};
+    carl::Scheduler scheduler(config.workers);
+    carl::Stream<std::vector<std::uint8_t>> frames;
+    std::optional<carl::Stream<carl::Payload<std::vector<std::uint8_t>>>> payloads;
+    if (shared) {
+        payloads = carl::stream_share(frames);
+    }
+    std::vector<std::unique_ptr<carl::Actor>> actors;
+    std::vector<carl::Subscription> subscriptions;
+    for (std::size_t i = 0; i < actor_count; ++i) {
+        actors.push_back(std::make_unique<carl::Actor>(scheduler));
+        const auto handler = [](const std::vector<std::uint8_t>& frame) { do_not_optimize(frame.back()); };
+        subscriptions.push_back(shared ? actors.back()->subscribe(*payloads, handler)
+                                       : actors.back()->subscribe(frames, handler));
+        scheduler.spawn(actors.back()->run());
+    }
+
+    const std::vector<std::uint8_t> frame(64 * 1024, 1);
+    result.ops = scaled(config, actor_count);
+    result.latency.resize(result.ops);
+    const auto start = Clock::now();
+    for (std::uint64_t i = 0; i < result.ops; ++i) {
+        const std::uint64_t sent = now_ns();
+        frames.emit(frame);
+        scheduler.run();
+        result.latency[i] = now_ns() - sent;
+    }
+    result.seconds = seconds_since(start);
+
+    for (auto& actor : actors) {
+        actor->stop();
+    }
+    scheduler.run();
+    return result;
+}
+
+// Many parked actors: waking each with one message. Parked actors cost no
+// scheduler work, so this is the wake-up path alone.
+Result bench_idle_actors(const Config& config, std::size_t count) {
+    Result result{"idle_actor_wakeup/" + std::to_string(count)};
+    carl::Scheduler scheduler(config.workers);
+    std::vector<std::unique_ptr<carl::Actor>> actors;
+    actors.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        actors.push_back(std::make_unique<carl::Actor>(scheduler));
+        scheduler.spawn(actors.back()->run());
+    }
+    scheduler.run();
+
+    result.ops = count;
+    result.latency.resize(count);
+    Histogram& latency = result.latency;
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint64_t sent = now_ns();
+        actors[i]->post([&latency, i, sent]() { latency[i] = now_ns() - sent; });
+    }
+    scheduler.run();
+    result.seconds = seconds_since(start);
+
+    for (auto& actor : actors) {
+        actor->stop();
+    }
+    scheduler.run();
+    return result;
+}
+
+carl::Task record_start(std::uint64_t spawned, std::uint64_t* slot) {
+    *slot = now_ns() - spawned;
+    co_return;
+}
+
+// Latency is spawn() to the first instruction of the task.
+Result bench_spawn(const Config& config) {
+    Result result{"scheduler_spawn"};
+    carl::Scheduler scheduler(config.workers);
+    result.ops = scaled(config, 1);
+    result.latency.resize(result.ops);
+    const auto start = Clock::now();
+    for (std::uint64_t i = 0; i < result.ops; ++i) {
+        scheduler.spawn(record_start(now_ns(), &result.latency[i]));
+    }
+    scheduler.run();
+    result.seconds = seconds_since(start);
+    return result;
+}
+
+carl::Task yield_loop(carl::Scheduler& scheduler, std::size_t count, std::uint64_t* gaps) {
+    std::uint64_t last = now_ns();
+    for (std::size_t i = 0; i < count; ++i) {
+        co_await scheduler.yield();
+        const std::uint64_t now = now_ns();
+        gaps[i] = now - last;
+        last = now;
+    }
+}
+
+// One yielding coroutine per worker; latency is the gap between resumes.
+Result bench_resume(const Config& config) {
+    Result result{"scheduler_resume"};
+    carl::Scheduler scheduler(config.workers);
+    const std::size_t tasks = scheduler.worker_count();
+    const std::size_t per_task = scaled(config, tasks);
+    result.ops = per_task * tasks;
+    result.latency.resize(result.ops);
+    const auto start = Clock::now();
+    for (std::size_t t = 0; t < tasks; ++t) {
+        scheduler.spawn(yield_loop(scheduler, per_task, &result.latency[t * per_task]));
+    }
+    scheduler.run();
+    result.seconds = seconds_since(start);
+    return result;
+}
+
+void write_json(std::ostream& out, const Config& config, std::vector<Result>& results) {
+    out << "{\n";
+    out << "  \"library\": \"carl\",\n";
+    out << "  \"workers\": " << config.workers << ",\n";
+    out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        Result& result = results[i];
+        const double ops_per_sec = result.seconds > 0.0 ? static_cast<double>(result.ops) / result.seconds : 0.0;
+        const double ns_per_op = result.ops > 0 ? result.seconds * 1e9 / static_cast<double>(result.ops) : 0.0;
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"name\": \"" << result.name << "\", \"ops\": " << result.ops
+            << ", \"seconds\": " << result.seconds << ", \"ops_per_sec\": " << ops_per_sec
+            << ", \"ns_per_op\": " << ns_per_op << ", \"latency_ns\": {\"samples\": " << result.latency.count()
+            << ", \"p50\": " << result.latency.percentile(0.50) << ", \"p99\": " << result.latency.percentile(0.99)
+            << ", \"p999\": " << result.latency.percentile(0.999) << ", \"max\": " << result.latency.max() << "}}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+bool parse_args(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--quick") {
+            config.ops = 2000;
+        } else if (arg == "--ops" && has_value) {
+            config.ops = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--workers" && has_value) {
+            config.workers = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--filter" && has_value) {
+            config.filter = argv[++i];
+        } else if (arg == "--output" && has_value) {
+            config.output = argv[++i];
+        } else {
+            std::cerr << "usage: carl_bench [--quick] [--ops N] [--workers N] [--filter substring] [--output file]\n";
+            return false;
+        }
+    }
+    if (config.workers == 0) {
+        config.workers = 1;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!parse_args(argc, argv, config)) {
+        return 2;
+    }
+
+    const std::vector<std::pair<std::string, std::function<Result()>>> cases = {
+        {"stream_emit_fanout/1", [&] { return bench_emit_fanout(config, 1); }},
+        {"stream_emit_fanout/10", [&] { return bench_emit_fanout(config, 10); }},
+        {"stream_emit_fanout/100", [&] { return bench_emit_fanout(config, 100); }},
+        {"stream_emit_fanout/1000", [&] { return bench_emit_fanout(config, 1000); }},
+        {"stream_map_chain/1", [&] { return bench_map_chain(config, 1); }},
+        {"stream_map_chain/16", [&] { return bench_map_chain(config, 16); }},
+        {"stream_map_chain/64", [&] { return bench_map_chain(config, 64); }},
+        {"signal_combine_diamond", [&] { return bench_combine_diamond(config); }},
+        {"engine_diamond", [&] { return bench_engine_diamond(config); }},
+        {"signal_read_contention/1", [&] { return bench_signal_read(config, 1); }},
+        {"signal_read_contention/4", [&] { return bench_signal_read(config, 4); }},
+        {"actor_post_contention/1", [&] { return bench_actor_post(config, 1); }},
+        {"actor_post_contention/4", [&] { return bench_actor_post(config, 4); }},
+        {"actor_post_contention/16", [&] { return bench_actor_post(config, 16); }},
+        {"actor_frame_fanout/copy", [&] { return bench_frame_fanout(config, false); }},
+        {"actor_frame_fanout/shared", [&] { return bench_frame_fanout(config, true); }},
+        {"idle_actor_wakeup/10000", [&] { return bench_idle_actors(config, 10000); }},
+        {"scheduler_spawn", [&] { return bench_spawn(config); }},
+        {"scheduler_resume", [&] { return bench_resume(config); }},
+    };
+
+    std::vector<Result> results;
+    for (const auto& [name, run] : cases) {
+        if (!config.filter.empty() && name.find(config.filter) == std::string::npos) {
+            continue;
+        }
+        std::cerr << "running " << name << "\n";
+        results.push_back(run());
+    }
+
+    if (config.output.empty()) {
+        write_json(std::cout, config, results);
+        return 0;
+    }
+    std::ofstream file(config.output);
+    if (!file) {
+        std::cerr << "cannot write " << config.output << "\n";
+        return 1;
+    }
+    write_json(file, config, results);
+    return 0;
+}
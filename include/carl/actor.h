@@ -1,10 +1,16 @@
 #pragma once
 
 #include <atomic>
-#include <functional>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
 #include <utility>
 
+#include "carl/channel.h"
+#include "carl/inline_function.h"
 #include "carl/mailbox.h"
+#include "carl/metrics.h"
 #include "carl/scheduler.h"
 #include "carl/signal.h"
 #include "carl/stream.h"
@@ -13,15 +19,44 @@
 
 namespace carl {
 
+struct ActorOptions {
+    static constexpr std::size_t default_batch_size = 64;
+
+    std::size_t batch_size{default_batch_size};
+    // Workers the actor runs on. Every resumption of run() -- the first one,
+    // mailbox wakeups and yields after a full batch -- is pinned to a worker
+    // of this group, so the actor's state stays in that core's cache.
+    std::optional<WorkerGroup> home{};
+};
+
 class Actor {
 public:
-    using Message = std::function<void()>;
+    static constexpr std::size_t message_inline_size = 80;
+    using Message = InlineFunction<void(), message_inline_size>;
 
-    explicit Actor(Scheduler& scheduler) : scheduler_(scheduler) {}
+    static constexpr std::size_t default_batch_size = ActorOptions::default_batch_size;
+
+    explicit Actor(Scheduler& scheduler, std::size_t batch_size = default_batch_size)
+        : Actor(scheduler, ActorOptions{.batch_size = batch_size}) {}
+
+    Actor(Scheduler& scheduler, ActorOptions options)
+        : scheduler_(scheduler),
+          batch_size_(options.batch_size == 0 ? 1 : options.batch_size),
+          home_(options.home) {
+        if (home_ && home_->count == 0) {
+            home_->count = 1;
+        }
+    }
     virtual ~Actor() = default;
 
     void post(Message message) {
-        mailbox_.push(std::move(message));
+        if (auto waiter = mailbox_.push(std::move(message))) {
+            if (home_) {
+                scheduler_.schedule_on(home_worker(), waiter);
+            } else {
+                scheduler_.schedule(waiter);
+            }
+        }
     }
 
     void stop() {
@@ -30,13 +65,29 @@ public:
     }
 
     Task run() {
+        if (home_) {
+            co_await scheduler_.resume_on(home_worker());
+        }
         on_start();
         while (running_.load()) {
-            Message message;
-            if (mailbox_.try_pop(message)) {
-                message();
-            } else {
+            const std::size_t handled = mailbox_.drain(batch_size_, [this](Message& message) {
+                if (running_.load(std::memory_order_relaxed)) {
+                    metrics_.messages.add();
+                    metrics::ScopedTimer timer(metrics_.handler_time);
+                    message();
+                }
+            });
+            // stop()'s wake-up message may have been consumed by this drain;
+            // parking now would never resume.
+            if (!running_.load()) {
+                break;
+            }
+            if (handled == batch_size_ && home_) {
+                co_await scheduler_.resume_on(home_worker());
+            } else if (handled == batch_size_) {
                 co_await scheduler_.yield();
+            } else {
+                co_await mailbox_.wait();
             }
         }
         on_stop();
@@ -44,20 +95,30 @@ public:
 
     template <typename T, typename Fn>
     Subscription subscribe(Stream<T>& stream, Fn&& handler) {
-        Actor* self = this;
-        auto callback = [self, func = std::forward<Fn>(handler)](const T& value) mutable {
-            self->post([func, value]() mutable { func(value); });
-        };
-        return stream.subscribe(std::move(callback));
+        return stream.subscribe(deliver_to<T>(std::forward<Fn>(handler)));
     }
 
     template <typename T, typename Fn>
     Subscription subscribe(Signal<T>& signal, Fn&& handler) {
-        Actor* self = this;
-        auto callback = [self, func = std::forward<Fn>(handler)](const T& value) mutable {
-            self->post([func, value]() mutable { func(value); });
-        };
-        return signal.subscribe(std::move(callback));
+        return signal.subscribe(deliver_to<T>(std::forward<Fn>(handler)));
+    }
+
+    // Bounded variants: events are buffered in a per-subscription channel of
+    // `options.capacity` and delivered in batches, with `options.policy`
+    // deciding what happens when the actor falls behind (drop_oldest unless
+    // set). OverflowPolicy::block stalls the emitting OS thread, so use it only
+    // for producers that do not run on a scheduler worker; conflate is usually
+    // what a Signal subscriber wants.
+    template <typename T, typename Fn>
+    BoundedSubscription subscribe(Stream<T>& stream, Backpressure options, Fn&& handler) {
+        auto channel = make_channel<T>(options, std::forward<Fn>(handler));
+        return bind_channel(stream.subscribe(feed(channel)), channel);
+    }
+
+    template <typename T, typename Fn>
+    BoundedSubscription subscribe(Signal<T>& signal, Backpressure options, Fn&& handler) {
+        auto channel = make_channel<T>(options, std::forward<Fn>(handler));
+        return bind_channel(signal.subscribe(feed(channel)), channel);
     }
 
     template <typename T>
@@ -79,8 +140,64 @@ protected:
     virtual void on_stop() {}
 
 private:
+    // Spreads resumptions over the home group round-robin.
+    std::size_t home_worker() {
+        if (home_->count == 1) {
+            return home_->first;
+        }
+        return home_->first + rotation_.fetch_add(1, std::memory_order_relaxed) % home_->count;
+    }
+
+    // The handler is stored once per subscription; each delivered event only
+    // enqueues the value and a reference to the shared handler.
+    template <typename T, typename Fn>
+    auto deliver_to(Fn&& handler) {
+        auto shared_handler = std::make_shared<std::decay_t<Fn>>(std::forward<Fn>(handler));
+        return [this, shared_handler](const T& value) {
+            post([shared_handler, value]() mutable { (*shared_handler)(value); });
+        };
+    }
+
+    template <typename T, typename Fn>
+    static auto make_channel(Backpressure options, Fn&& handler) {
+        return std::make_shared<BoundedChannel<T, std::decay_t<Fn>>>(options, std::forward<Fn>(handler));
+    }
+
+    template <typename Channel>
+    auto feed(const std::shared_ptr<Channel>& channel) {
+        return [this, channel](const auto& value) {
+            if (channel->push(value)) {
+                schedule_drain(channel);
+            }
+        };
+    }
+
+    template <typename Channel>
+    void schedule_drain(std::shared_ptr<Channel> channel) {
+        post([this, channel = std::move(channel)]() mutable {
+            if (channel->drain()) {
+                schedule_drain(std::move(channel));
+            }
+        });
+    }
+
+    template <typename Channel>
+    static BoundedSubscription bind_channel(Subscription subscription, std::shared_ptr<Channel> channel) {
+        auto inner = std::make_shared<Subscription>(std::move(subscription));
+        return BoundedSubscription(
+            [inner, channel]() {
+                inner->unsubscribe();
+                channel->close();
+            },
+            channel);
+    }
+
     Scheduler& scheduler_;
+    std::size_t batch_size_;
+    std::optional<WorkerGroup> home_;
+    std::atomic<std::size_t> rotation_{0};
     Mailbox<Message> mailbox_{};
+    metrics::ActorMetrics metrics_{mailbox_.metrics()};
     std::atomic<bool> running_{true};
 };
 
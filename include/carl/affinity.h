@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace carl {
+
+// Parses a Linux cpulist ("0-3,8,10-11") into CPU indices. Malformed
+// entries are skipped.
+inline std::vector<int> parse_cpu_list(std::string_view list) {
+    std::vector<int> cpus;
+    while (!list.empty()) {
+        const std::size_t comma = list.find(',');
+        std::string_view entry = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+        int first = -1;
+        int last = -1;
+        int* target = &first;
+        for (char c : entry) {
+            if (c >= '0' && c <= '9') {
+                *target = (*target < 0 ? 0 : *target * 10) + (c - '0');
+            } else if (c == '-' && target == &first && first >= 0) {
+                target = &last;
+            } else if (c != ' ' && c != '\n') {
+                first = -1;
+                break;
+            }
+        }
+        if (first < 0) {
+            continue;
+        }
+        if (target == &first) {
+            last = first;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// CPUs of a NUMA node as reported by sysfs; empty when the node does not
+// exist or the platform does not expose the topology.
+inline std::vector<int> numa_node_cpus(int node) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!file || !std::getline(file, list)) {
+        return {};
+    }
+    return parse_cpu_list(list);
+}
+
+// Restricts `thread` to `cpus`. Returns false if pinning is unsupported or
+// rejected (for example a CPU outside the process's allowed set); the
+// thread then keeps running unpinned.
+inline bool pin_thread(std::thread::native_handle_type thread, const std::vector<int>& cpus) {
+#if defined(__linux__)
+    if (cpus.empty()) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    (void)cpus;
+    return false;
+#endif
+}
+
+}  // namespace carl
@@ -1,8 +1,12 @@
 #pragma once
 
 #include "carl/actor.h"
+#include "carl/payload.h"
+#include "carl/pipeline.h"
+#include "carl/propagation_engine.h"
 #include "carl/reactive_context.h"
 #include "carl/reactor.h"
 #include "carl/scheduler.h"
 #include "carl/signal.h"
 #include "carl/stream.h"
+#include "carl/stream_simd.h"
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "carl/subscription.h"
+
+namespace carl {
+
+enum class OverflowPolicy : std::uint8_t {
+    // Blocks the producing OS thread until the consumer makes room. Only for
+    // producers outside the scheduler: a blocked worker is not available to
+    // run the actor's drain, so with all workers blocked nothing makes room.
+    block,
+    // Evicts the oldest buffered event to make room for the new one.
+    drop_oldest,
+    // Discards the incoming event.
+    drop_newest,
+    // Keeps only the latest value; a new value replaces the buffered one.
+    conflate,
+};
+
+// The default policy never blocks, so it is safe wherever the producer
+// runs, including scheduled emits and ReactiveContext operators.
+struct Backpressure {
+    std::size_t capacity{1024};
+    OverflowPolicy policy{OverflowPolicy::drop_oldest};
+};
+
+// Type-erased view of a channel's counters, shared with BoundedSubscription.
+class ChannelStats {
+public:
+    virtual ~ChannelStats() = default;
+
+    std::uint64_t dropped() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    virtual std::size_t size() const = 0;
+
+protected:
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+// Bounded single-consumer buffer between a producer callback and an actor.
+// Events sit in a fixed ring; the actor's mailbox only ever holds one drain
+// message per channel, so a slow actor costs at most `capacity` buffered
+// events per subscription instead of an unbounded mailbox.
+template <typename T, typename Handler>
+class BoundedChannel final : public ChannelStats {
+public:
+    BoundedChannel(Backpressure options, Handler handler)
+        : policy_(options.policy),
+          capacity_(options.policy == OverflowPolicy::conflate || options.capacity == 0 ? 1 : options.capacity),
+          buffer_(capacity_),
+          handler_(std::move(handler)) {}
+
+    // Buffers `value` according to the overflow policy. Returns true when the
+    // caller must schedule a drain (the channel was idle).
+    bool push(const T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+        if (count_ == capacity_) {
+            switch (policy_) {
+            case OverflowPolicy::block:
+                not_full_.wait(lock, [this]() { return count_ < capacity_ || closed_; });
+                if (closed_) {
+                    return false;
+                }
+                break;
+            case OverflowPolicy::drop_oldest:
+                buffer_[head_].reset();
+                head_ = (head_ + 1) % capacity_;
+                --count_;
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case OverflowPolicy::drop_newest:
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case OverflowPolicy::conflate:
+                buffer_[(head_ + count_ - 1) % capacity_].emplace(value);
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        buffer_[(head_ + count_) % capacity_].emplace(value);
+        ++count_;
+        return !std::exchange(scheduled_, true);
+    }
+
+    // Hands up to `capacity` buffered events to the handler. Returns true if
+    // events remain and the drain must be scheduled again.
+    bool drain() {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            std::optional<T> value;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (count_ == 0) {
+                    scheduled_ = false;
+                    return false;
+                }
+                value.swap(buffer_[head_]);
+                head_ = (head_ + 1) % capacity_;
+                --count_;
+            }
+            if (policy_ == OverflowPolicy::block) {
+                not_full_.notify_one();
+            }
+            handler_(*value);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        scheduled_ = count_ != 0;
+        return scheduled_;
+    }
+
+    // Drops buffered events and releases blocked producers.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            count_ = 0;
+            for (auto& slot : buffer_) {
+                slot.reset();
+            }
+        }
+        not_full_.notify_all();
+    }
+
+    std::size_t size() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+private:
+    const OverflowPolicy policy_;
+    const std::size_t capacity_;
+    mutable std::mutex mutex_{};
+    std::condition_variable not_full_{};
+    // Slots hold values only while they are buffered, so T needs no
+    // default constructor.
+    std::vector<std::optional<T>> buffer_;
+    std::size_t head_{0};
+    std::size_t count_{0};
+    bool scheduled_{false};
+    bool closed_{false};
+    Handler handler_;
+};
+
+// Subscription to a bounded channel; also reports how many events the
+// overflow policy discarded. Unsubscribing closes the channel.
+class BoundedSubscription : public Subscription {
+public:
+    BoundedSubscription() = default;
+    BoundedSubscription(std::function<void()> cancel, std::shared_ptr<const ChannelStats> stats)
+        : Subscription(std::move(cancel)), stats_(std::move(stats)) {}
+
+    std::uint64_t dropped() const noexcept {
+        return stats_ ? stats_->dropped() : 0;
+    }
+
+    std::size_t buffered() const {
+        return stats_ ? stats_->size() : 0;
+    }
+
+private:
+    std::shared_ptr<const ChannelStats> stats_{};
+};
+
+}  // namespace carl
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "carl/metrics.h"
+
+namespace carl {
+
+// Topology of a reactive graph: nodes with names and operator kinds, and
+// the edges between them. ReactiveContext fills it in when created with
+// ReactiveContextOptions{.record_graph = true}. Entries hold only a weak
+// probe, so the registry never keeps a node alive; nodes that are gone
+// are left out of queries and exports, and their entries are pruned as new
+// nodes are added.
+class GraphRegistry {
+public:
+    using NodeId = const void*;
+    using Probe = std::function<std::optional<metrics::NodeStats>()>;
+
+    struct NodeInfo {
+        NodeId id{nullptr};
+        std::string name{};
+        std::string kind{};
+        std::string op{};
+        std::vector<NodeId> inputs{};
+        // Live readings; emits and callback_time are zero unless metrics
+        // are compiled in.
+        metrics::NodeStats stats{};
+    };
+
+    // Records `node` as the output of operator `op`.
+    template <typename Node>
+    void add(const Node& node, std::string op, std::initializer_list<NodeId> inputs = {}) {
+        add(node.id(), node.probe(), std::move(op), inputs);
+    }
+
+    // Records an input that was created outside the registry, if unknown.
+    template <typename Node>
+    void add_source(const Node& node) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto found = index_.find(node.id());
+        if (found == index_.end() || !entries_[found->second].probe()) {
+            insert(node.id(), node.probe(), "source", {});
+        }
+    }
+
+    void set_name(NodeId id, std::string name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto found = index_.find(id); found != index_.end()) {
+            entries_[found->second].name = std::move(name);
+        }
+    }
+
+    std::vector<NodeInfo> nodes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<NodeInfo> result;
+        std::vector<const Entry*> live_entries;
+        result.reserve(entries_.size());
+        for (const auto& entry : entries_) {
+            if (auto stats = entry.probe()) {
+                result.push_back(NodeInfo{entry.id, entry.name, stats->kind, entry.op, {}, *stats});
+                live_entries.push_back(&entry);
+            }
+        }
+        // Edges name the input's serial, so an input that died is dropped
+        // even when a newer node now lives at its address.
+        std::unordered_map<std::uint64_t, NodeId> live;
+        for (const Entry* entry : live_entries) {
+            live.emplace(entry->serial, entry->id);
+        }
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            for (const std::uint64_t input : live_entries[i]->inputs) {
+                if (const auto found = live.find(input); found != live.end()) {
+                    result[i].inputs.push_back(found->second);
+                }
+            }
+        }
+        return result;
+    }
+
+    // Distinct live nodes downstream of `source`, transitively: how many
+    // nodes one update of it can reach.
+    std::size_t fan_out(NodeId source) const {
+        const Graph graph = build();
+        const auto start = graph.position.find(source);
+        if (start == graph.position.end()) {
+            return 0;
+        }
+        std::vector<bool> seen(graph.nodes.size(), false);
+        std::vector<std::size_t> pending{start->second};
+        std::size_t reached = 0;
+        while (!pending.empty()) {
+            const std::size_t current = pending.back();
+            pending.pop_back();
+            for (const std::size_t next : graph.outputs[current]) {
+                if (!seen[next]) {
+                    seen[next] = true;
+                    ++reached;
+                    pending.push_back(next);
+                }
+            }
+        }
+        return reached;
+    }
+
+    // The most expensive source-to-sink chain. Each node weighs its mean
+    // callback time in nanoseconds when metrics are available, otherwise 1,
+    // so without metrics this is the longest chain of hops.
+    std::vector<NodeId> critical_path() const {
+        const Graph graph = build();
+        const std::size_t count = graph.nodes.size();
+        std::vector<std::size_t> pending_inputs(count, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            for (const std::size_t next : graph.outputs[i]) {
+                ++pending_inputs[next];
+            }
+        }
+
+        std::vector<std::uint64_t> cost(count, 0);
+        std::vector<std::size_t> previous(count, count);
+        std::vector<std::size_t> ready;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (pending_inputs[i] == 0) {
+                ready.push_back(i);
+                cost[i] = weight(graph.nodes[i]);
+            }
+        }
+        std::size_t best = count;
+        while (!ready.empty()) {
+            const std::size_t current = ready.back();
+            ready.pop_back();
+            if (best == count || cost[current] > cost[best]) {
+                best = current;
+            }
+            for (const std::size_t next : graph.outputs[current]) {
+                const std::uint64_t through = cost[current] + weight(graph.nodes[next]);
+                if (through > cost[next]) {
+                    cost[next] = through;
+                    previous[next] = current;
+                }
+                if (--pending_inputs[next] == 0) {
+                    ready.push_back(next);
+                }
+            }
+        }
+
+        std::vector<NodeId> path;
+        for (std::size_t at = best; at != count; at = previous[at]) {
+            path.push_back(graph.nodes[at].id);
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    std::string to_dot() const {
+        const auto live = nodes();
+        const auto labels = short_ids(live);
+        std::ostringstream out;
+        out << "digraph carl {\n    rankdir=LR;\n";
+        for (const auto& node : live) {
+            out << "    " << labels.at(node.id) << " [shape=" << (node.kind == "signal" ? "ellipse" : "box")
+                << ", label=\"" << escape(display_name(node, labels)) << "\\n" << node.op
+                << "\\nemits=" << node.stats.emits << " observers=" << node.stats.observers << "\"];\n";
+        }
+        for (const auto& node : live) {
+            for (const NodeId input : node.inputs) {
+                if (labels.contains(input)) {
+                    out << "    " << labels.at(input) << " -> " << labels.at(node.id) << ";\n";
+                }
+            }
+        }
+        out << "}\n";
+        return out.str();
+    }
+
+    std::string to_json() const {
+        const auto live = nodes();
+        const auto labels = short_ids(live);
+        std::ostringstream out;
+        out << "{\"nodes\":[";
+        for (std::size_t i = 0; i < live.size(); ++i) {
+            const auto& node = live[i];
+            out << (i == 0 ? "" : ",") << "{\"id\":\"" << labels.at(node.id) << "\",\"name\":\""
+                << escape(node.name) << "\",\"kind\":\"" << node.kind << "\",\"op\":\"" << node.op
+                << "\",\"emits\":" << node.stats.emits << ",\"observers\":" << node.stats.observers
+                << ",\"callback_ns\":" << node.stats.callback_time.sum_ns
+                << ",\"callback_p99_ns\":" << node.stats.callback_time.percentile_ns(0.99) << '}';
+        }
+        out << "],\"edges\":[";
+        bool first = true;
+        for (const auto& node : live) {
+            for (const NodeId input : node.inputs) {
+                if (labels.contains(input)) {
+                    out << (first ? "" : ",") << "{\"from\":\"" << labels.at(input) << "\",\"to\":\""
+                        << labels.at(node.id) << "\"}";
+                    first = false;
+                }
+            }
+        }
+        out << "]}\n";
+        return out.str();
+    }
+
+private:
+    // Nodes are told apart by serial, which is never reused; an address
+    // may be, once the node that had it is gone.
+    struct Entry {
+        NodeId id;
+        std::uint64_t serial;
+        Probe probe;
+        std::string op;
+        std::vector<std::uint64_t> inputs;
+        std::string name{};
+    };
+
+    // Live nodes with outgoing edges by position.
+    struct Graph {
+        std::vector<NodeInfo> nodes;
+        std::unordered_map<NodeId, std::size_t> position;
+        std::vector<std::vector<std::size_t>> outputs;
+    };
+
+    void add(NodeId id, Probe probe, std::string op, std::initializer_list<NodeId> inputs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insert(id, std::move(probe), std::move(op), inputs);
+    }
+
+    // Called with mutex_ held. A node at the address of a dead one takes
+    // over its slot under a new serial, so edges to the dead one stay dead.
+    void insert(NodeId id, Probe probe, std::string op, std::initializer_list<NodeId> inputs) {
+        Entry entry{id, next_serial_++, std::move(probe), std::move(op), {}};
+        entry.inputs.reserve(inputs.size());
+        for (const NodeId input : inputs) {
+            if (const auto found = index_.find(input); found != index_.end()) {
+                entry.inputs.push_back(entries_[found->second].serial);
+            }
+        }
+        if (const auto found = index_.find(id); found != index_.end()) {
+            entries_[found->second] = std::move(entry);
+            return;
+        }
+        if (entries_.size() >= prune_at_) {
+            prune();
+        }
+        index_.emplace(id, entries_.size());
+        entries_.push_back(std::move(entry));
+    }
+
+    // Called with mutex_ held. Drops entries whose nodes are gone. Runs
+    // once the table has doubled since the last prune, so it stays
+    // proportional to the live graph at amortized constant cost per add.
+    void prune() {
+        std::erase_if(entries_, [](const Entry& entry) { return !entry.probe(); });
+        index_.clear();
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            index_.emplace(entries_[i].id, i);
+        }
+        prune_at_ = std::max<std::size_t>(entries_.size() * 2, min_prune_at);
+    }
+
+    Graph build() const {
+        Graph graph{nodes(), {}, {}};
+        graph.outputs.resize(graph.nodes.size());
+        for (std::size_t i = 0; i < graph.nodes.size(); ++i) {
+            graph.position.emplace(graph.nodes[i].id, i);
+        }
+        for (std::size_t i = 0; i < graph.nodes.size(); ++i) {
+            for (const NodeId input : graph.nodes[i].inputs) {
+                if (const auto found = graph.position.find(input); found != graph.position.end()) {
+                    graph.outputs[found->second].push_back(i);
+                }
+            }
+        }
+        return graph;
+    }
+
+    static std::uint64_t weight(const NodeInfo& node) {
+        const auto& time = node.stats.callback_time;
+        return time.count == 0 ? 1 : std::max<std::uint64_t>(time.sum_ns / time.count, 1);
+    }
+
+    static std::unordered_map<NodeId, std::string> short_ids(const std::vector<NodeInfo>& live) {
+        std::unordered_map<NodeId, std::string> labels;
+        for (std::size_t i = 0; i < live.size(); ++i) {
+            labels.emplace(live[i].id, "n" + std::to_string(i));
+        }
+        return labels;
+    }
+
+    static std::string display_name(const NodeInfo& node, const std::unordered_map<NodeId, std::string>& labels) {
+        return node.name.empty() ? labels.at(node.id) : node.name;
+    }
+
+    static std::string escape(std::string_view text) {
+        std::string result;
+        result.reserve(text.size());
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                result.push_back('\\');
+            }
+            result.push_back(c);
+        }
+        return result;
+    }
+
+    static constexpr std::size_t min_prune_at = 64;
+
+    mutable std::mutex mutex_{};
+    std::vector<Entry> entries_{};
+    std::unordered_map<NodeId, std::size_t> index_{};
+    std::uint64_t next_serial_{0};
+    std::size_t prune_at_{min_prune_at};
+};
+
+}  // namespace carl
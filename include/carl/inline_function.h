@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace carl {
+
+template <typename Signature, std::size_t Capacity = 64>
+class InlineFunction;
+
+// Move-only type-erased callable. Callables that fit in Capacity bytes (and are
+// nothrow movable and not over-aligned) are stored inline with no allocation;
+// anything larger falls back to a single heap allocation.
+template <typename R, typename... Args, std::size_t Capacity>
+class InlineFunction<R(Args...), Capacity> {
+    static_assert(Capacity >= sizeof(void*));
+
+public:
+    static constexpr std::size_t capacity = Capacity;
+
+    template <typename Fn>
+    static constexpr bool stores_inline = sizeof(Fn) <= Capacity &&
+                                          alignof(Fn) <= alignof(std::max_align_t) &&
+                                          std::is_nothrow_move_constructible_v<Fn>;
+
+    InlineFunction() noexcept = default;
+    InlineFunction(std::nullptr_t) noexcept {}
+
+    template <typename Fn>
+        requires(!std::is_same_v<std::remove_cvref_t<Fn>, InlineFunction> &&
+                 std::is_invocable_r_v<R, std::decay_t<Fn>&, Args...>)
+    InlineFunction(Fn&& fn) {
+        using Stored = std::decay_t<Fn>;
+        if constexpr (stores_inline<Stored>) {
+            ::new (static_cast<void*>(storage_)) Stored(std::forward<Fn>(fn));
+            ops_ = &inline_ops<Stored>;
+        } else {
+            ::new (static_cast<void*>(storage_)) Stored*(new Stored(std::forward<Fn>(fn)));
+            ops_ = &heap_ops<Stored>;
+        }
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept : ops_(std::exchange(other.ops_, nullptr)) {
+        if (ops_ != nullptr) {
+            ops_->relocate(storage_, other.storage_);
+        }
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops_ = std::exchange(other.ops_, nullptr);
+            if (ops_ != nullptr) {
+                ops_->relocate(storage_, other.storage_);
+            }
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    InlineFunction(const InlineFunction&) = delete;
+    InlineFunction& operator=(const InlineFunction&) = delete;
+
+    ~InlineFunction() {
+        reset();
+    }
+
+    R operator()(Args... args) {
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept {
+        return ops_ != nullptr;
+    }
+
+private:
+    struct Ops {
+        R (*invoke)(void*, Args&&...);
+        void (*relocate)(void* destination, void* source) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr Ops inline_ops{
+        [](void* storage, Args&&... args) -> R {
+            return std::invoke_r<R>(*static_cast<Fn*>(storage), std::forward<Args>(args)...);
+        },
+        [](void* destination, void* source) noexcept {
+            Fn* from = static_cast<Fn*>(source);
+            ::new (destination) Fn(std::move(*from));
+            from->~Fn();
+        },
+        [](void* storage) noexcept { static_cast<Fn*>(storage)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops heap_ops{
+        [](void* storage, Args&&... args) -> R {
+            return std::invoke_r<R>(**static_cast<Fn**>(storage), std::forward<Args>(args)...);
+        },
+        [](void* destination, void* source) noexcept {
+            ::new (destination) Fn*(*static_cast<Fn**>(source));
+        },
+        [](void* storage) noexcept { delete *static_cast<Fn**>(storage); },
+    };
+
+    void reset() noexcept {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) std::byte storage_[Capacity];
+    const Ops* ops_{nullptr};
+};
+
+}  // namespace carl
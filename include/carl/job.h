@@ -0,0 +1,47 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include "carl/memory_pool.h"
+#include "carl/mpsc_queue.h"
+
+namespace carl {
+
+// A unit of work that runs to completion without suspending. Jobs are cheaper
+// than a Task: no coroutine frame, no promise, and the node itself is
+// intrusive, so it can be queued without any extra allocation.
+struct Job : MpscNode {
+    using Invoke = void (*)(Job*);
+
+    explicit Job(Invoke function) : invoke(function) {}
+
+    // Runs the job and releases it; the pointer is dangling afterwards.
+    void run() {
+        invoke(this);
+    }
+
+    Invoke invoke;
+};
+
+template <typename Fn>
+class FunctionJob final : public Job, public PoolAllocated {
+public:
+    explicit FunctionJob(Fn fn) : Job(&FunctionJob::execute), fn_(std::move(fn)) {}
+
+private:
+    static void execute(Job* job) {
+        auto* self = static_cast<FunctionJob*>(job);
+        self->fn_();
+        delete self;
+    }
+
+    Fn fn_;
+};
+
+template <typename Fn>
+Job* make_job(Fn&& fn) {
+    return new FunctionJob<std::decay_t<Fn>>(std::forward<Fn>(fn));
+}
+
+}  // namespace carl
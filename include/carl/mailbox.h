@@ -1,36 +1,159 @@
 #pragma once
 
-#include <mutex>
-#include <queue>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "carl/memory_pool.h"
+#include "carl/metrics.h"
+#include "carl/mpsc_queue.h"
+#include "carl/trace.h"
 
 namespace carl {
 
+// Lock-free multi-producer/single-consumer mailbox. push() may be called from
+// any thread; try_pop(), drain(), empty() and wait() belong to the consumer.
 template <typename T>
 class Mailbox {
 public:
-    void push(T message) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        queue_.push(std::move(message));
+    struct WaitAwaitable {
+        Mailbox* mailbox{};
+
+        bool await_ready() const {
+            return !mailbox->empty();
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) const {
+            return mailbox->park(handle);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    Mailbox() = default;
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    ~Mailbox() {
+        while (Node* node = queue_.pop()) {
+            delete node;
+        }
+    }
+
+    // Returns the parked consumer when this push is the one that wakes it; the
+    // caller is responsible for scheduling the returned handle.
+    [[nodiscard]] std::coroutine_handle<> push(T message) {
+        // Counted before it is linked, so a consumer that is parking sees
+        // either the count or, through unpark(), gets woken.
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        queue_.push(new Node(std::move(message)));
+        metrics_.depth.add();
+        return unpark();
     }
 
     bool try_pop(T& out) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (queue_.empty()) {
+        Node* node = queue_.pop();
+        if (node == nullptr) {
             return false;
         }
-        out = std::move(queue_.front());
-        queue_.pop();
+        record_dequeue(*node);
+        out = std::move(node->value);
+        delete node;
         return true;
     }
 
+    // Hands up to `limit` messages to fn(T&) and returns how many were handled.
+    template <typename Fn>
+    std::size_t drain(std::size_t limit, Fn&& fn) {
+        std::size_t handled = 0;
+        while (handled < limit) {
+            Node* node = queue_.pop();
+            if (node == nullptr) {
+                break;
+            }
+            record_dequeue(*node);
+            {
+                trace::Scope scope("mailbox.handle", node->hop);
+                fn(node->value);
+            }
+            delete node;
+            ++handled;
+        }
+        return handled;
+    }
+
     bool empty() const {
-        std::lock_guard<std::mutex> lock(mutex_);
         return queue_.empty();
     }
 
+    WaitAwaitable wait() {
+        return WaitAwaitable{this};
+    }
+
+    // Depth and enqueue-to-dequeue latency; no-ops unless metrics are enabled.
+    const metrics::MailboxMetrics& metrics() const noexcept {
+        return metrics_;
+    }
+
 private:
-    mutable std::mutex mutex_{};
-    std::queue<T> queue_{};
+    struct Node : MpscNode, PoolAllocated {
+        explicit Node(T message) : value(std::move(message)) {}
+
+        T value;
+        [[no_unique_address]] metrics::Timestamp enqueued{};
+        [[no_unique_address]] trace::Hop hop{"mailbox.post"};
+    };
+
+    void record_dequeue(const Node& node) {
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        metrics_.depth.sub();
+        metrics_.queue_latency.record(node.enqueued.elapsed_ns());
+    }
+
+    // State word: the low bit is set while the consumer is parked, the rest
+    // counts parks. Every park uses a new generation, so a CAS that lost a
+    // race against a wakeup cannot succeed against a later park.
+    static constexpr std::uint64_t parked_bit = 1;
+
+    // The consumer publishes its handle, then re-checks the pending count. A
+    // producer counts its message, then checks the state. The fences order
+    // each side's store before its load, and whichever side clears the
+    // parked bit owns the wakeup, so it happens exactly once and cannot be
+    // lost. Once the handle is published the consumer may already be
+    // running elsewhere, so only atomics are touched after that.
+    bool park(std::coroutine_handle<> handle) {
+        waiter_ = handle;
+        const std::uint64_t parked = (state_.load(std::memory_order_relaxed) | parked_bit) + 2;
+        state_.store(parked, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pending_.load(std::memory_order_relaxed) == 0) {
+            return true;
+        }
+        std::uint64_t expected = parked;
+        return !state_.compare_exchange_strong(expected, parked & ~parked_bit, std::memory_order_acq_rel);
+    }
+
+    std::coroutine_handle<> unpark() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t state = state_.load(std::memory_order_relaxed);
+        if ((state & parked_bit) == 0) {
+            return {};
+        }
+        if (!state_.compare_exchange_strong(state, state & ~parked_bit, std::memory_order_acq_rel)) {
+            return {};
+        }
+        return waiter_;
+    }
+
+    IntrusiveMpscQueue<Node> queue_{};
+    alignas(64) std::atomic<std::uint64_t> state_{0};
+    // Messages pushed and not yet popped; written by both sides.
+    std::atomic<std::int64_t> pending_{0};
+    std::coroutine_handle<> waiter_{};
+    metrics::MailboxMetrics metrics_{};
 };
 
 }  // namespace carl
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace carl {
+
+// Size-class block allocator for short-lived fixed-size objects such as
+// mailbox nodes. Each thread keeps small free lists; when one grows past
+// local_limit, a batch of blocks is handed to a shared depot, and an empty
+// list refills a whole batch from the depot. Blocks freed on a different
+// thread than the one that allocated them (actor producers and consumers
+// usually differ) therefore recirculate instead of going back to malloc.
+class MemoryPool {
+public:
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t size_classes = 16;
+    static constexpr std::size_t max_pooled_size = granularity * size_classes;
+    static constexpr std::size_t transfer_batch = 32;
+    static constexpr std::size_t local_limit = transfer_batch * 2;
+    static constexpr std::size_t depot_limit = 1024;
+
+    static void* allocate(std::size_t size) {
+        if (size == 0 || size > max_pooled_size || cache_destroyed_) {
+            return ::operator new(size);
+        }
+        const std::size_t index = class_index(size);
+        FreeList& list = cache().lists[index];
+        if (list.head == nullptr) {
+            depot().take(index, list);
+        }
+        if (list.head != nullptr) {
+            Block* block = list.head;
+            list.head = block->next;
+            --list.count;
+            return block;
+        }
+        return ::operator new((index + 1) * granularity);
+    }
+
+    static void deallocate(void* pointer, std::size_t size) noexcept {
+        if (pointer == nullptr) {
+            return;
+        }
+        if (size == 0 || size > max_pooled_size || cache_destroyed_) {
+            ::operator delete(pointer);
+            return;
+        }
+        const std::size_t index = class_index(size);
+        FreeList& list = cache().lists[index];
+        list.head = ::new (pointer) Block{list.head};
+        ++list.count;
+        if (list.count > local_limit) {
+            depot().give(index, list);
+        }
+    }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    struct FreeList {
+        Block* head{nullptr};
+        std::size_t count{0};
+    };
+
+    static std::size_t class_index(std::size_t size) noexcept {
+        return (size - 1) / granularity;
+    }
+
+    static void release(Block* head) noexcept {
+        while (head != nullptr) {
+            Block* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+    }
+
+    class Depot {
+    public:
+        ~Depot() {
+            for (auto& shelf : shelves_) {
+                for (Block* batch : shelf.batches) {
+                    release(batch);
+                }
+            }
+        }
+
+        void take(std::size_t index, FreeList& list) {
+            Shelf& shelf = shelves_[index];
+            std::lock_guard<std::mutex> lock(shelf.mutex);
+            if (shelf.batches.empty()) {
+                return;
+            }
+            list.head = shelf.batches.back();
+            list.count = transfer_batch;
+            shelf.batches.pop_back();
+        }
+
+        void give(std::size_t index, FreeList& list) noexcept {
+            Block* batch = list.head;
+            Block* last = batch;
+            for (std::size_t i = 1; i < transfer_batch; ++i) {
+                last = last->next;
+            }
+            list.head = last->next;
+            list.count -= transfer_batch;
+            last->next = nullptr;
+
+            Shelf& shelf = shelves_[index];
+            std::lock_guard<std::mutex> lock(shelf.mutex);
+            if (shelf.batches.size() >= depot_limit) {
+                release(batch);
+                return;
+            }
+            try {
+                shelf.batches.push_back(batch);
+            } catch (...) {
+                release(batch);
+            }
+        }
+
+    private:
+        struct Shelf {
+            std::mutex mutex;
+            std::vector<Block*> batches;
+        };
+
+        std::array<Shelf, size_classes> shelves_{};
+    };
+
+    struct Cache {
+        ~Cache() {
+            cache_destroyed_ = true;
+            for (auto& list : lists) {
+                release(list.head);
+                list.head = nullptr;
+            }
+        }
+
+        std::array<FreeList, size_classes> lists{};
+    };
+
+    static Cache& cache() {
+        thread_local Cache instance;
+        return instance;
+    }
+
+    static Depot& depot() {
+        static Depot instance;
+        return instance;
+    }
+
+    inline static thread_local bool cache_destroyed_ = false;
+};
+
+// Base class that routes a type's operator new/delete through MemoryPool.
+// Over-aligned types bypass the pool and use the aligned global operators.
+struct PoolAllocated {
+    static void* operator new(std::size_t size) {
+        return MemoryPool::allocate(size);
+    }
+
+    static void operator delete(void* pointer, std::size_t size) noexcept {
+        MemoryPool::deallocate(pointer, size);
+    }
+
+    static void* operator new(std::size_t size, std::align_val_t alignment) {
+        return ::operator new(size, alignment);
+    }
+
+    static void operator delete(void* pointer, std::size_t size, std::align_val_t alignment) noexcept {
+        ::operator delete(pointer, size, alignment);
+    }
+};
+
+}  // namespace carl
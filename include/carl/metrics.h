@@ -0,0 +1,446 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Runtime instrumentation. Define CARL_ENABLE_METRICS=1 (CMake:
+// -DCARL_METRICS=ON) to turn it on; otherwise every counter, histogram and
+// timer below is an empty type whose operations compile to nothing and no
+// clock is read.
+#ifndef CARL_ENABLE_METRICS
+#define CARL_ENABLE_METRICS 0
+#endif
+
+namespace carl::metrics {
+
+inline constexpr bool enabled = CARL_ENABLE_METRICS != 0;
+
+inline std::uint64_t now_ns() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+}
+
+// Log2 buckets: bucket i counts samples in [2^i, 2^(i+1)) ns (bucket 0 also
+// takes 0), so 40 buckets reach about 18 minutes.
+struct HistogramSnapshot {
+    static constexpr std::size_t bucket_count = 40;
+
+    std::uint64_t count{0};
+    std::uint64_t sum_ns{0};
+    std::array<std::uint64_t, bucket_count> buckets{};
+
+    static std::uint64_t bucket_upper_ns(std::size_t bucket) {
+        return std::uint64_t{2} << bucket;
+    }
+
+    // Upper bound of the bucket holding the p-quantile.
+    std::uint64_t percentile_ns(double p) const {
+        if (count == 0) {
+            return 0;
+        }
+        const auto rank = static_cast<std::uint64_t>(p * static_cast<double>(count - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return bucket_upper_ns(i);
+            }
+        }
+        return bucket_upper_ns(bucket_count - 1);
+    }
+};
+
+#if CARL_ENABLE_METRICS
+
+class Counter {
+public:
+    void add(std::uint64_t amount = 1) noexcept {
+        value_.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    std::uint64_t load() const noexcept {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void add(std::int64_t amount = 1) noexcept {
+        value_.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void sub(std::int64_t amount = 1) noexcept {
+        value_.fetch_sub(amount, std::memory_order_relaxed);
+    }
+
+    std::int64_t load() const noexcept {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::int64_t> value_{0};
+};
+
+class Histogram {
+public:
+    void record(std::uint64_t ns) noexcept {
+        const std::size_t bucket = ns == 0 ? 0 : static_cast<std::size_t>(std::bit_width(ns)) - 1;
+        buckets_[std::min(bucket, HistogramSnapshot::bucket_count - 1)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot result;
+        result.count = count_.load(std::memory_order_relaxed);
+        result.sum_ns = sum_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < HistogramSnapshot::bucket_count; ++i) {
+            result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, HistogramSnapshot::bucket_count> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+};
+
+// A point in time, taken on construction.
+class Timestamp {
+public:
+    std::uint64_t elapsed_ns() const {
+        return now_ns() - start_;
+    }
+
+private:
+    std::uint64_t start_{now_ns()};
+};
+
+// Records its lifetime into a histogram.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram) : histogram_(&histogram) {}
+    explicit ScopedTimer(Histogram* histogram) : histogram_(histogram) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        if (histogram_ != nullptr) {
+            histogram_->record(start_.elapsed_ns());
+        }
+    }
+
+private:
+    Histogram* histogram_;
+    Timestamp start_{};
+};
+
+#else
+
+class Counter {
+public:
+    void add(std::uint64_t = 1) noexcept {}
+
+    std::uint64_t load() const noexcept {
+        return 0;
+    }
+};
+
+class Gauge {
+public:
+    void add(std::int64_t = 1) noexcept {}
+    void sub(std::int64_t = 1) noexcept {}
+
+    std::int64_t load() const noexcept {
+        return 0;
+    }
+};
+
+class Histogram {
+public:
+    void record(std::uint64_t) noexcept {}
+
+    HistogramSnapshot snapshot() const {
+        return {};
+    }
+};
+
+class Timestamp {
+public:
+    std::uint64_t elapsed_ns() const {
+        return 0;
+    }
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram&) noexcept {}
+    explicit ScopedTimer(Histogram*) noexcept {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#endif
+
+struct NodeStats {
+    std::string kind{};
+    std::uintptr_t id{0};
+    std::uint64_t emits{0};
+    std::size_t observers{0};
+    HistogramSnapshot callback_time{};
+};
+
+struct ActorStats {
+    std::uintptr_t id{0};
+    std::int64_t mailbox_depth{0};
+    std::uint64_t messages{0};
+    HistogramSnapshot queue_latency{};
+    HistogramSnapshot handler_time{};
+};
+
+struct WorkerStats {
+    std::size_t index{0};
+    std::uint64_t tasks_run{0};
+    std::uint64_t steals{0};
+    std::uint64_t idle_ns{0};
+    std::size_t queue_length{0};
+    std::size_t inbox_length{0};
+};
+
+// Scheduler::stats() snapshot. Queue lengths and outstanding work are live
+// readings and always present; the counters, histograms, nodes and actors
+// stay empty unless metrics are enabled.
+struct SchedulerStats {
+    std::vector<WorkerStats> workers{};
+    std::size_t injected{0};
+    std::size_t outstanding{0};
+    std::size_t pending_timers{0};
+    std::vector<NodeStats> nodes{};
+    std::vector<ActorStats> actors{};
+};
+
+struct MailboxMetrics {
+    Gauge depth{};
+    Histogram queue_latency{};
+};
+
+#if CARL_ENABLE_METRICS
+
+// Per Signal/Stream metrics. Each instance registers itself with the global
+// Registry for its lifetime; `observers` reports the live observer count at
+// snapshot time.
+class NodeMetrics {
+public:
+    template <typename ObserverCount>
+    NodeMetrics(const char* kind, ObserverCount&& observers)
+        : kind_(kind), observers_(std::forward<ObserverCount>(observers)) {
+        attach();
+    }
+
+    ~NodeMetrics() {
+        detach();
+    }
+
+    NodeMetrics(const NodeMetrics&) = delete;
+    NodeMetrics& operator=(const NodeMetrics&) = delete;
+
+    NodeStats stats() const {
+        return NodeStats{kind_, reinterpret_cast<std::uintptr_t>(this), emits.load(), observers_(),
+                         callback_time.snapshot()};
+    }
+
+    Counter emits{};
+    Histogram callback_time{};
+
+private:
+    void attach();
+    void detach();
+
+    const char* kind_;
+    std::function<std::size_t()> observers_;
+};
+
+class ActorMetrics {
+public:
+    explicit ActorMetrics(const MailboxMetrics& mailbox) : mailbox_(mailbox) {
+        attach();
+    }
+
+    ~ActorMetrics() {
+        detach();
+    }
+
+    ActorMetrics(const ActorMetrics&) = delete;
+    ActorMetrics& operator=(const ActorMetrics&) = delete;
+
+    ActorStats stats() const {
+        return ActorStats{reinterpret_cast<std::uintptr_t>(this), mailbox_.depth.load(), messages.load(),
+                          mailbox_.queue_latency.snapshot(), handler_time.snapshot()};
+    }
+
+    Counter messages{};
+    Histogram handler_time{};
+
+private:
+    void attach();
+    void detach();
+
+    const MailboxMetrics& mailbox_;
+};
+
+// Process-wide list of live instrumented nodes and actors.
+class Registry {
+public:
+    static Registry& global() {
+        static Registry registry;
+        return registry;
+    }
+
+    template <typename Metrics>
+    void add(const Metrics* metrics) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        list<Metrics>().push_back(metrics);
+    }
+
+    template <typename Metrics>
+    void remove(const Metrics* metrics) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::erase(list<Metrics>(), metrics);
+    }
+
+    std::vector<NodeStats> nodes() const {
+        return collect<NodeStats>(nodes_);
+    }
+
+    std::vector<ActorStats> actors() const {
+        return collect<ActorStats>(actors_);
+    }
+
+private:
+    template <typename Metrics>
+    auto& list() {
+        if constexpr (std::is_same_v<Metrics, NodeMetrics>) {
+            return nodes_;
+        } else {
+            return actors_;
+        }
+    }
+
+    template <typename Stats, typename Metrics>
+    std::vector<Stats> collect(const std::vector<const Metrics*>& entries) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Stats> result;
+        result.reserve(entries.size());
+        for (const auto* entry : entries) {
+            result.push_back(entry->stats());
+        }
+        return result;
+    }
+
+    mutable std::mutex mutex_{};
+    std::vector<const NodeMetrics*> nodes_{};
+    std::vector<const ActorMetrics*> actors_{};
+};
+
+inline void NodeMetrics::attach() {
+    Registry::global().add(this);
+}
+
+inline void NodeMetrics::detach() {
+    Registry::global().remove(this);
+}
+
+inline void ActorMetrics::attach() {
+    Registry::global().add(this);
+}
+
+inline void ActorMetrics::detach() {
+    Registry::global().remove(this);
+}
+
+// Keeps a node's metrics alive inside a scheduled dispatch.
+using NodeRef = std::shared_ptr<NodeMetrics>;
+
+template <typename State>
+NodeRef node_ref(const std::shared_ptr<State>& state) {
+    return NodeRef(state, &state->metrics);
+}
+
+inline Histogram* callback_histogram(const NodeRef& node) {
+    return &node->callback_time;
+}
+
+#else
+
+class NodeMetrics {
+public:
+    template <typename ObserverCount>
+    NodeMetrics(const char*, ObserverCount&&) noexcept {}
+
+    NodeMetrics(const NodeMetrics&) = delete;
+    NodeMetrics& operator=(const NodeMetrics&) = delete;
+
+    Counter emits{};
+    Histogram callback_time{};
+};
+
+class ActorMetrics {
+public:
+    explicit ActorMetrics(const MailboxMetrics&) noexcept {}
+
+    ActorMetrics(const ActorMetrics&) = delete;
+    ActorMetrics& operator=(const ActorMetrics&) = delete;
+
+    Counter messages{};
+    Histogram handler_time{};
+};
+
+class Registry {
+public:
+    static Registry& global() {
+        static Registry registry;
+        return registry;
+    }
+
+    std::vector<NodeStats> nodes() const {
+        return {};
+    }
+
+    std::vector<ActorStats> actors() const {
+        return {};
+    }
+};
+
+struct NodeRef {};
+
+template <typename State>
+NodeRef node_ref(const std::shared_ptr<State>&) {
+    return {};
+}
+
+inline Histogram* callback_histogram(const NodeRef&) {
+    return nullptr;
+}
+
+#endif
+
+}  // namespace carl::metrics
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "carl/metrics.h"
+
+namespace carl::metrics {
+
+namespace detail {
+
+inline std::string hex_id(std::uintptr_t id) {
+    std::ostringstream out;
+    out << "0x" << std::hex << id;
+    return out.str();
+}
+
+inline void prometheus_family(std::ostream& out, std::string_view name, std::string_view type,
+                              std::string_view help) {
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+}
+
+// Cumulative buckets up to the highest non-empty one, then +Inf.
+inline void prometheus_histogram(std::ostream& out, std::string_view name, const std::string& labels,
+                                 const HistogramSnapshot& histogram) {
+    std::size_t last = 0;
+    for (std::size_t i = 0; i < HistogramSnapshot::bucket_count; ++i) {
+        if (histogram.buckets[i] != 0) {
+            last = i;
+        }
+    }
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; histogram.count != 0 && i <= last; ++i) {
+        cumulative += histogram.buckets[i];
+        out << name << "_bucket{" << labels << ",le=\""
+            << static_cast<double>(HistogramSnapshot::bucket_upper_ns(i)) / 1e9 << "\"} " << cumulative << '\n';
+    }
+    out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << histogram.count << '\n';
+    out << name << "_sum{" << labels << "} " << static_cast<double>(histogram.sum_ns) / 1e9 << '\n';
+    out << name << "_count{" << labels << "} " << histogram.count << '\n';
+}
+
+inline void json_histogram(std::ostream& out, const HistogramSnapshot& histogram) {
+    out << "{\"count\":" << histogram.count << ",\"sum_ns\":" << histogram.sum_ns
+        << ",\"p50_ns\":" << histogram.percentile_ns(0.50) << ",\"p99_ns\":" << histogram.percentile_ns(0.99)
+        << ",\"p999_ns\":" << histogram.percentile_ns(0.999) << '}';
+}
+
+}  // namespace detail
+
+// Prometheus text exposition format (version 0.0.4). Latencies are in
+// seconds; histogram quantiles are bucket upper bounds.
+inline std::string to_prometheus(const SchedulerStats& stats) {
+    std::ostringstream out;
+    const auto worker_label = [](const WorkerStats& worker) {
+        return "worker=\"" + std::to_string(worker.index) + "\"";
+    };
+    const auto node_label = [](const NodeStats& node) {
+        return "kind=\"" + node.kind + "\",node=\"" + detail::hex_id(node.id) + "\"";
+    };
+    const auto actor_label = [](const ActorStats& actor) { return "actor=\"" + detail::hex_id(actor.id) + "\""; };
+
+    detail::prometheus_family(out, "carl_worker_tasks_run_total", "counter", "Work items run by the worker.");
+    for (const auto& worker : stats.workers) {
+        out << "carl_worker_tasks_run_total{" << worker_label(worker) << "} " << worker.tasks_run << '\n';
+    }
+    detail::prometheus_family(out, "carl_worker_steals_total", "counter", "Work items stolen from other workers.");
+    for (const auto& worker : stats.workers) {
+        out << "carl_worker_steals_total{" << worker_label(worker) << "} " << worker.steals << '\n';
+    }
+    detail::prometheus_family(out, "carl_worker_idle_seconds_total", "counter", "Time spent without work.");
+    for (const auto& worker : stats.workers) {
+        out << "carl_worker_idle_seconds_total{" << worker_label(worker) << "} "
+            << static_cast<double>(worker.idle_ns) / 1e9 << '\n';
+    }
+    detail::prometheus_family(out, "carl_worker_queue_length", "gauge", "Items in the worker's deque.");
+    for (const auto& worker : stats.workers) {
+        out << "carl_worker_queue_length{" << worker_label(worker) << "} " << worker.queue_length << '\n';
+    }
+    detail::prometheus_family(out, "carl_worker_inbox_length", "gauge", "Items pinned to the worker.");
+    for (const auto& worker : stats.workers) {
+        out << "carl_worker_inbox_length{" << worker_label(worker) << "} " << worker.inbox_length << '\n';
+    }
+
+    detail::prometheus_family(out, "carl_scheduler_injected", "gauge", "Items in the shared injection queue.");
+    out << "carl_scheduler_injected " << stats.injected << '\n';
+    detail::prometheus_family(out, "carl_scheduler_outstanding", "gauge", "Work queued or running.");
+    out << "carl_scheduler_outstanding " << stats.outstanding << '\n';
+    detail::prometheus_family(out, "carl_scheduler_pending_timers", "gauge", "Timers not yet due.");
+    out << "carl_scheduler_pending_timers " << stats.pending_timers << '\n';
+
+    detail::prometheus_family(out, "carl_node_emits_total", "counter", "Values set or emitted on the node.");
+    for (const auto& node : stats.nodes) {
+        out << "carl_node_emits_total{" << node_label(node) << "} " << node.emits << '\n';
+    }
+    detail::prometheus_family(out, "carl_node_observers", "gauge", "Live observers of the node.");
+    for (const auto& node : stats.nodes) {
+        out << "carl_node_observers{" << node_label(node) << "} " << node.observers << '\n';
+    }
+    detail::prometheus_family(out, "carl_node_callback_seconds", "histogram", "Time spent notifying observers.");
+    for (const auto& node : stats.nodes) {
+        detail::prometheus_histogram(out, "carl_node_callback_seconds", node_label(node), node.callback_time);
+    }
+
+    detail::prometheus_family(out, "carl_actor_mailbox_depth", "gauge", "Messages waiting in the mailbox.");
+    for (const auto& actor : stats.actors) {
+        out << "carl_actor_mailbox_depth{" << actor_label(actor) << "} " << actor.mailbox_depth << '\n';
+    }
+    detail::prometheus_family(out, "carl_actor_messages_total", "counter", "Messages handled.");
+    for (const auto& actor : stats.actors) {
+        out << "carl_actor_messages_total{" << actor_label(actor) << "} " << actor.messages << '\n';
+    }
+    detail::prometheus_family(out, "carl_actor_queue_latency_seconds", "histogram", "Enqueue-to-dequeue latency.");
+    for (const auto& actor : stats.actors) {
+        detail::prometheus_histogram(out, "carl_actor_queue_latency_seconds", actor_label(actor),
+                                     actor.queue_latency);
+    }
+    detail::prometheus_family(out, "carl_actor_handler_seconds", "histogram", "Message handler run time.");
+    for (const auto& actor : stats.actors) {
+        detail::prometheus_histogram(out, "carl_actor_handler_seconds", actor_label(actor), actor.handler_time);
+    }
+    return out.str();
+}
+
+inline std::string to_json(const SchedulerStats& stats) {
+    std::ostringstream out;
+    out << "{\"injected\":" << stats.injected << ",\"outstanding\":" << stats.outstanding
+        << ",\"pending_timers\":" << stats.pending_timers << ",\"workers\":[";
+    for (std::size_t i = 0; i < stats.workers.size(); ++i) {
+        const auto& worker = stats.workers[i];
+        out << (i == 0 ? "" : ",") << "{\"index\":" << worker.index << ",\"tasks_run\":" << worker.tasks_run
+            << ",\"steals\":" << worker.steals << ",\"idle_ns\":" << worker.idle_ns
+            << ",\"queue_length\":" << worker.queue_length << ",\"inbox_length\":" << worker.inbox_length << '}';
+    }
+    out << "],\"nodes\":[";
+    for (std::size_t i = 0; i < stats.nodes.size(); ++i) {
+        const auto& node = stats.nodes[i];
+        out << (i == 0 ? "" : ",") << "{\"kind\":\"" << node.kind << "\",\"id\":\"" << detail::hex_id(node.id)
+            << "\",\"emits\":" << node.emits << ",\"observers\":" << node.observers << ",\"callback_time\":";
+        detail::json_histogram(out, node.callback_time);
+        out << '}';
+    }
+    out << "],\"actors\":[";
+    for (std::size_t i = 0; i < stats.actors.size(); ++i) {
+        const auto& actor = stats.actors[i];
+        out << (i == 0 ? "" : ",") << "{\"id\":\"" << detail::hex_id(actor.id)
+            << "\",\"mailbox_depth\":" << actor.mailbox_depth << ",\"messages\":" << actor.messages
+            << ",\"queue_latency\":";
+        detail::json_histogram(out, actor.queue_latency);
+        out << ",\"handler_time\":";
+        detail::json_histogram(out, actor.handler_time);
+        out << '}';
+    }
+    out << "]}\n";
+    return out.str();
+}
+
+// Dumps a snapshot to `path`: JSON when the path ends in ".json", the
+// Prometheus text format otherwise (e.g. for node_exporter's textfile
+// collector). Returns false if the file cannot be written.
+inline bool write_metrics(const SchedulerStats& stats, const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file << (path.ends_with(".json") ? to_json(stats) : to_prometheus(stats));
+    return static_cast<bool>(file);
+}
+
+}  // namespace carl::metrics
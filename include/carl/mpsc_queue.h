@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+
+namespace carl {
+
+struct MpscNode {
+    std::atomic<MpscNode*> next{nullptr};
+};
+
+// Vyukov's intrusive multi-producer/single-consumer queue. push() is wait-free
+// and may be called from any thread; pop() and empty() belong to the single
+// consumer. A producer that has swapped head_ but not yet linked its node makes
+// the queue look momentarily empty to the consumer.
+template <typename Node>
+class IntrusiveMpscQueue {
+public:
+    IntrusiveMpscQueue() = default;
+
+    IntrusiveMpscQueue(const IntrusiveMpscQueue&) = delete;
+    IntrusiveMpscQueue& operator=(const IntrusiveMpscQueue&) = delete;
+
+    void push(Node* node) {
+        link(node);
+    }
+
+    Node* pop() {
+        MpscNode* tail = tail_;
+        MpscNode* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<Node*>(tail);
+        }
+
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        link(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<Node*>(tail);
+        }
+        return nullptr;
+    }
+
+    bool empty() const {
+        return tail_ == &stub_ && stub_.next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    void link(MpscNode* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        MpscNode* previous = head_.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    MpscNode stub_{};
+    alignas(64) std::atomic<MpscNode*> head_{&stub_};
+    alignas(64) MpscNode* tail_{&stub_};
+};
+
+}  // namespace carl
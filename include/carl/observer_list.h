@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace carl {
+
+// Copy-on-write observer list. Readers load an immutable, reference-counted
+// snapshot and iterate it without taking a lock or copying; subscribe and
+// unsubscribe serialize on a writer mutex.
+//
+// Subscriptions are addressed through a generation-tagged slot map: every
+// add() stamps its slot with a fresh generation, so a stale handle can never
+// cancel whoever reuses the slot. Unsubscribing only deactivates the observer
+// (in-flight snapshots skip it from then on); the snapshot is compacted once
+// dead entries outnumber live ones, which keeps memory and emit cost
+// proportional to the live subscribers.
+template <typename Callback>
+class ObserverList {
+public:
+    struct Observer {
+        explicit Observer(Callback fn) : callback(std::move(fn)) {}
+
+        Callback callback;
+        std::atomic<bool> active{true};
+    };
+
+    struct Handle {
+        std::uint32_t index{0};
+        std::uint32_t generation{0};
+    };
+
+    using Snapshot = std::vector<std::shared_ptr<Observer>>;
+
+    static constexpr std::size_t min_compaction_threshold = 16;
+
+    ObserverList() : snapshot_(std::make_shared<const Snapshot>()) {}
+
+    std::shared_ptr<const Snapshot> snapshot() const {
+        return snapshot_.load(std::memory_order_acquire);
+    }
+
+    template <typename... Args>
+    static void notify(const Snapshot& snapshot, const Args&... args) {
+        for (const auto& observer : snapshot) {
+            if (observer->active.load(std::memory_order_acquire)) {
+                observer->callback(args...);
+            }
+        }
+    }
+
+    Handle add(Callback callback) {
+        auto observer = std::make_shared<Observer>(std::move(callback));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::uint32_t index;
+        if (free_slots_.empty()) {
+            index = static_cast<std::uint32_t>(slots_.size());
+            slots_.emplace_back();
+        } else {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+        }
+        slots_[index].observer = observer;
+        slots_[index].generation = next_generation_++;
+        ++live_;
+
+        auto current = snapshot_.load(std::memory_order_relaxed);
+        auto next = std::make_shared<Snapshot>();
+        next->reserve(current->size() + 1);
+        next->assign(current->begin(), current->end());
+        next->push_back(std::move(observer));
+        snapshot_.store(std::move(next), std::memory_order_release);
+
+        return Handle{index, slots_[index].generation};
+    }
+
+    void remove(Handle handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (handle.index >= slots_.size()) {
+            return;
+        }
+        Slot& slot = slots_[handle.index];
+        if (slot.generation != handle.generation || !slot.observer) {
+            return;
+        }
+
+        slot.observer->active.store(false, std::memory_order_release);
+        slot.observer.reset();
+        free_slots_.push_back(handle.index);
+        --live_;
+        ++dead_;
+
+        if (dead_ >= std::max(live_, min_compaction_threshold)) {
+            compact();
+        }
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return live_;
+    }
+
+private:
+    struct Slot {
+        std::uint32_t generation{0};
+        std::shared_ptr<Observer> observer{};
+    };
+
+    // Drops deactivated observers from the published snapshot and trims free
+    // slots off the end of the slot table. Called with mutex_ held.
+    void compact() {
+        auto current = snapshot_.load(std::memory_order_relaxed);
+        auto next = std::make_shared<Snapshot>();
+        next->reserve(live_);
+        for (const auto& observer : *current) {
+            if (observer->active.load(std::memory_order_relaxed)) {
+                next->push_back(observer);
+            }
+        }
+        snapshot_.store(std::move(next), std::memory_order_release);
+        dead_ = 0;
+
+        while (!slots_.empty() && !slots_.back().observer) {
+            slots_.pop_back();
+        }
+        std::erase_if(free_slots_, [this](std::uint32_t index) { return index >= slots_.size(); });
+        if (slots_.capacity() > 2 * slots_.size() + min_compaction_threshold) {
+            slots_.shrink_to_fit();
+            free_slots_.shrink_to_fit();
+        }
+    }
+
+    mutable std::mutex mutex_{};
+    std::vector<Slot> slots_{};
+    std::vector<std::uint32_t> free_slots_{};
+    std::uint32_t next_generation_{1};
+    std::size_t live_{0};
+    std::size_t dead_{0};
+    std::atomic<std::shared_ptr<const Snapshot>> snapshot_;
+};
+
+}  // namespace carl
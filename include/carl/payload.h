@@ -0,0 +1,66 @@
+#pragma once
+
+#include <concepts>
+#include <memory>
+#include <utility>
+
+namespace carl {
+
+// An immutable, reference-counted value. Copying a Payload shares the one
+// underlying T, so a large value emitted on a Stream<Payload<T>> reaches
+// every observer, scheduled dispatch and actor mailbox without being
+// copied. It converts to const T&, so handlers and operator functions can
+// take the value type directly.
+template <typename T>
+class Payload {
+public:
+    Payload() = default;
+    explicit Payload(T value) : value_(std::make_shared<const T>(std::move(value))) {}
+    explicit Payload(std::shared_ptr<const T> value) noexcept : value_(std::move(value)) {}
+
+    const T& get() const noexcept {
+        return *value_;
+    }
+
+    const T& operator*() const noexcept {
+        return *value_;
+    }
+
+    const T* operator->() const noexcept {
+        return value_.get();
+    }
+
+    operator const T&() const noexcept {
+        return *value_;
+    }
+
+    explicit operator bool() const noexcept {
+        return static_cast<bool>(value_);
+    }
+
+    // Number of Payloads sharing the value.
+    long use_count() const noexcept {
+        return value_.use_count();
+    }
+
+    // Values compare equal without touching T when they are shared.
+    friend bool operator==(const Payload& left, const Payload& right)
+        requires std::equality_comparable<T>
+    {
+        if (left.value_ == right.value_) {
+            return true;
+        }
+        return left.value_ && right.value_ && *left.value_ == *right.value_;
+    }
+
+private:
+    std::shared_ptr<const T> value_{};
+};
+
+// Builds the value in place, in the same allocation as its reference count.
+template <typename T, typename... Args>
+Payload<T> make_payload(Args&&... args) {
+    return Payload<T>(std::make_shared<const T>(std::forward<Args>(args)...));
+}
+
+}  // namespace carl
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "carl/scheduler.h"
+#include "carl/stream.h"
+#include "carl/subscription.h"
+
+namespace carl {
+
+// Fused operator chains. `source | map(f) | filter(p) | map(g) | to_stream()`
+// composes the stages at compile time into one callback subscribed to the
+// source, and produces a single output Stream: one observer list and one
+// dispatch per event however long the chain is, and the compiler sees the
+// whole path. A Stream in the middle of a chain exists only where one is
+// asked for with to_stream().
+struct PipelineStage {};
+
+template <typename Fn>
+struct MapStage : PipelineStage {
+    template <typename In>
+    using Output = std::decay_t<std::invoke_result_t<Fn&, const In&>>;
+
+    template <typename Next>
+    auto bind(Next next) && {
+        return [fn = std::move(fn), next = std::move(next)](const auto& value) mutable { next(fn(value)); };
+    }
+
+    Fn fn;
+};
+
+template <typename Pred>
+struct FilterStage : PipelineStage {
+    template <typename In>
+    using Output = In;
+
+    template <typename Next>
+    auto bind(Next next) && {
+        return [pred = std::move(pred), next = std::move(next)](const auto& value) mutable {
+            if (pred(value)) {
+                next(value);
+            }
+        };
+    }
+
+    Pred pred;
+};
+
+template <typename Fn>
+MapStage<std::decay_t<Fn>> map(Fn&& fn) {
+    return {{}, std::forward<Fn>(fn)};
+}
+
+template <typename Pred>
+FilterStage<std::decay_t<Pred>> filter(Pred&& pred) {
+    return {{}, std::forward<Pred>(pred)};
+}
+
+// Terminal stages.
+struct ToStream {
+    Scheduler* scheduler{nullptr};
+};
+
+inline ToStream to_stream() {
+    return {};
+}
+
+// Output events are dispatched as Scheduler jobs, like stream_map(scheduler, ...).
+inline ToStream to_stream(Scheduler& scheduler) {
+    return {&scheduler};
+}
+
+template <typename Fn>
+struct ForEach {
+    Fn fn;
+};
+
+// Runs `fn` on every output event; the chain lives as long as the returned
+// Subscription.
+template <typename Fn>
+ForEach<std::decay_t<Fn>> for_each(Fn&& fn) {
+    return {std::forward<Fn>(fn)};
+}
+
+template <typename In, typename... Stages>
+struct PipelineOutput {
+    using type = In;
+};
+
+template <typename In, typename Stage, typename... Rest>
+struct PipelineOutput<In, Stage, Rest...> {
+    using type = typename PipelineOutput<typename Stage::template Output<In>, Rest...>::type;
+};
+
+template <typename T, typename... Stages>
+class Pipeline {
+public:
+    Pipeline(Stream<T>& source, std::tuple<Stages...> stages) : source_(source), stages_(std::move(stages)) {}
+
+    using Output = typename PipelineOutput<T, Stages...>::type;
+
+    template <typename Stage>
+    Pipeline<T, Stages..., Stage> then(Stage stage) && {
+        return {source_, std::tuple_cat(std::move(stages_), std::make_tuple(std::move(stage)))};
+    }
+
+    Stream<Output> materialize(Scheduler* scheduler) && {
+        Stream<Output> output;
+        if (scheduler != nullptr) {
+            output.keep_alive(std::move(*this).subscribe_fused([output, scheduler](const Output& value) mutable {
+                output.emit(*scheduler, value);
+            }));
+        } else {
+            output.keep_alive(std::move(*this).subscribe_fused([output](const Output& value) mutable { output.emit(value); }));
+        }
+        return output;
+    }
+
+    template <typename Sink>
+    Subscription subscribe_fused(Sink sink) && {
+        auto fused = std::move(*this).template fuse<0>(std::move(sink));
+        return source_.subscribe([fused = std::move(fused)](const T& value) mutable { fused(value); });
+    }
+
+private:
+    template <std::size_t I, typename Sink>
+    auto fuse(Sink sink) && {
+        if constexpr (I == sizeof...(Stages)) {
+            return sink;
+        } else {
+            auto next = std::move(*this).template fuse<I + 1>(std::move(sink));
+            return std::get<I>(std::move(stages_)).bind(std::move(next));
+        }
+    }
+
+    Stream<T>& source_;
+    std::tuple<Stages...> stages_;
+};
+
+template <typename Stage>
+concept PipelineStageType = std::is_base_of_v<PipelineStage, Stage>;
+
+template <typename T, PipelineStageType Stage>
+Pipeline<T, Stage> operator|(Stream<T>& source, Stage stage) {
+    return {source, std::make_tuple(std::move(stage))};
+}
+
+template <typename T, typename... Stages, PipelineStageType Stage>
+Pipeline<T, Stages..., Stage> operator|(Pipeline<T, Stages...>&& pipeline, Stage stage) {
+    return std::move(pipeline).then(std::move(stage));
+}
+
+template <typename T, typename... Stages>
+auto operator|(Pipeline<T, Stages...>&& pipeline, ToStream terminal) {
+    return std::move(pipeline).materialize(terminal.scheduler);
+}
+
+template <typename T, typename... Stages, typename Fn>
+Subscription operator|(Pipeline<T, Stages...>&& pipeline, ForEach<Fn> terminal) {
+    return std::move(pipeline).subscribe_fused(std::move(terminal.fn));
+}
+
+}  // namespace carl
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "carl/inline_function.h"
+#include "carl/scheduler.h"
+
+namespace carl {
+
+// One glitch-free propagation pass over a Signal graph. While a propagation
+// is current on a thread, Signal::set stores its value and defers notifying
+// observers, and derived nodes defer their recomputation, each keyed by the
+// node's topological rank. The pass then drains the deferred work one level
+// at a time in (rank, phase) order, so every node recomputes at most once and
+// only after all of its inputs have settled. Work within a level is
+// independent and fans out across the Scheduler.
+class Propagation {
+public:
+    enum class Phase : std::uint8_t { recompute, notify };
+    using Work = InlineFunction<void()>;
+    using Completion = InlineFunction<void()>;
+
+    class Scope {
+    public:
+        explicit Scope(Propagation* propagation) : previous_(std::exchange(current_, propagation)) {}
+        ~Scope() {
+            current_ = previous_;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Propagation* previous_;
+    };
+
+    explicit Propagation(Scheduler& scheduler) : scheduler_(scheduler) {}
+
+    Propagation(const Propagation&) = delete;
+    Propagation& operator=(const Propagation&) = delete;
+
+    static Propagation* current() noexcept {
+        return current_;
+    }
+
+    // Queues work for `node`; later requests for the same node and phase are
+    // dropped, since the first one already observes the settled inputs.
+    template <typename Fn>
+    void defer(std::size_t rank, Phase phase, const void* node, Fn&& work) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& seen = phase == Phase::recompute ? recomputed_ : notified_;
+        if (!seen.insert(node).second) {
+            return;
+        }
+        pending_[Level{rank, phase}].emplace_back(std::forward<Fn>(work));
+    }
+
+    // Runs `body` (typically a batch of Signal::set calls) as the root of the
+    // propagation, then drains every level; `done` runs once nothing is left.
+    void start(Work body, Completion done) {
+        body_ = std::move(body);
+        done_ = std::move(done);
+        scheduler_.submit([this]() {
+            {
+                Scope scope(this);
+                body_();
+            }
+            advance();
+        });
+    }
+
+private:
+    using Level = std::pair<std::size_t, Phase>;
+
+    void advance() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!pending_.empty()) {
+                auto next = pending_.begin();
+                level_ = std::move(next->second);
+                pending_.erase(next);
+            } else {
+                level_.clear();
+            }
+        }
+
+        if (level_.empty()) {
+            auto done = std::move(done_);
+            done();
+            return;
+        }
+
+        const std::size_t count = level_.size();
+        remaining_.store(count, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < count; ++i) {
+            scheduler_.submit([this, i]() {
+                {
+                    Scope scope(this);
+                    level_[i]();
+                }
+                if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    advance();
+                }
+            });
+        }
+    }
+
+    inline static thread_local Propagation* current_ = nullptr;
+
+    Scheduler& scheduler_;
+    std::mutex mutex_{};
+    std::map<Level, std::vector<Work>> pending_{};
+    std::unordered_set<const void*> recomputed_{};
+    std::unordered_set<const void*> notified_{};
+    std::vector<Work> level_{};
+    std::atomic<std::size_t> remaining_{0};
+    Work body_{};
+    Completion done_{};
+};
+
+// Signal writes recorded by an open transaction instead of being applied.
+// Batches are per thread and nest: an inner batch hands its writes to the
+// enclosing one when it closes, so only the outermost batch commits.
+class WriteBatch {
+public:
+    static WriteBatch* current() noexcept {
+        return current_;
+    }
+
+    void record(Propagation::Work write) {
+        writes_.push_back(std::move(write));
+    }
+
+    WriteBatch(const WriteBatch&) = delete;
+    WriteBatch& operator=(const WriteBatch&) = delete;
+
+protected:
+    WriteBatch() : outer_(std::exchange(current_, this)) {}
+    ~WriteBatch() {
+        current_ = outer_;
+    }
+
+    // Closes the batch. Returns the recorded writes if this is the outermost
+    // batch; otherwise they are appended to the enclosing batch.
+    std::vector<Propagation::Work> close() {
+        current_ = outer_;
+        if (outer_ == nullptr) {
+            return std::move(writes_);
+        }
+        for (auto& write : writes_) {
+            outer_->record(std::move(write));
+        }
+        writes_.clear();
+        return {};
+    }
+
+private:
+    inline static thread_local WriteBatch* current_ = nullptr;
+
+    WriteBatch* outer_;
+    std::vector<Propagation::Work> writes_{};
+};
+
+}  // namespace carl
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "carl/propagation.h"
+#include "carl/scheduler.h"
+#include "carl/signal.h"
+
+namespace carl {
+
+class Transaction;
+
+// Glitch-free alternative to Signal::set(Scheduler&, ...). Each set() becomes
+// one Propagation: the whole downstream graph settles in rank order, every
+// affected node recomputes exactly once, and observers only see consistent
+// values. Propagations run one at a time, in submission order.
+class PropagationEngine {
+public:
+    explicit PropagationEngine(Scheduler& scheduler) : scheduler_(scheduler) {}
+
+    PropagationEngine(const PropagationEngine&) = delete;
+    PropagationEngine& operator=(const PropagationEngine&) = delete;
+
+    Scheduler& scheduler() const {
+        return scheduler_;
+    }
+
+    template <typename T>
+    void set(Signal<T>& signal, T value) {
+        submit([signal, payload = std::move(value)]() mutable { signal.set(std::move(payload)); });
+    }
+
+    // Queues `body` to run as the root of a propagation; every Signal::set it
+    // performs is settled together.
+    void submit(Propagation::Work body) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(body));
+            if (busy_) {
+                return;
+            }
+            busy_ = true;
+        }
+        start_next();
+    }
+
+    // Runs `fn` with a Transaction open: every Signal::set it performs is
+    // applied together as a single propagation once `fn` returns.
+    template <typename Fn>
+    void transaction(Fn&& fn);
+
+private:
+    void start_next() {
+        Propagation::Work body;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty()) {
+                busy_ = false;
+                active_.reset();
+                return;
+            }
+            body = std::move(queue_.front());
+            queue_.pop_front();
+            active_ = std::make_unique<Propagation>(scheduler_);
+        }
+        active_->start(std::move(body), [this]() { start_next(); });
+    }
+
+    Scheduler& scheduler_;
+    std::mutex mutex_{};
+    std::deque<Propagation::Work> queue_{};
+    std::unique_ptr<Propagation> active_{};
+    bool busy_{false};
+};
+
+// RAII batch scope. Signal writes made on this thread while the scope is open
+// are recorded rather than applied, and on close they are submitted to the
+// engine as one propagation: each dirty downstream node recomputes once and
+// observers only see the final state. Reads inside the scope still return
+// the pre-transaction values. If the scope unwinds because of an exception,
+// the recorded writes are discarded.
+class Transaction : public WriteBatch {
+public:
+    explicit Transaction(PropagationEngine& engine)
+        : engine_(engine), uncaught_(std::uncaught_exceptions()) {}
+
+    ~Transaction() {
+        auto writes = close();
+        if (writes.empty() || std::uncaught_exceptions() > uncaught_) {
+            return;
+        }
+        engine_.submit([writes = std::move(writes)]() mutable {
+            for (auto& write : writes) {
+                write();
+            }
+        });
+    }
+
+private:
+    PropagationEngine& engine_;
+    int uncaught_;
+};
+
+template <typename Fn>
+void PropagationEngine::transaction(Fn&& fn) {
+    Transaction scope(*this);
+    std::forward<Fn>(fn)();
+}
+
+}  // namespace carl
@@ -1,58 +1,186 @@
 #pragma once
 
+#include <memory>
+#include <string>
 #include <utility>
 
+#include "carl/graph_registry.h"
+#include "carl/propagation_engine.h"
 #include "carl/scheduler.h"
 #include "carl/signal.h"
 #include "carl/stream.h"
+#include "carl/stream_simd.h"
 
 namespace carl {
 
+struct ReactiveContextOptions {
+    // Record every node built through the context in a GraphRegistry.
+    bool record_graph{false};
+};
+
 class ReactiveContext {
 public:
-    explicit ReactiveContext(Scheduler& scheduler) : scheduler_(scheduler) {}
+    explicit ReactiveContext(Scheduler& scheduler) : ReactiveContext(scheduler, ReactiveContextOptions{}) {}
+
+    ReactiveContext(Scheduler& scheduler, ReactiveContextOptions options)
+        : scheduler_(scheduler),
+          engine_(scheduler),
+          graph_(options.record_graph ? std::make_unique<GraphRegistry>() : nullptr) {}
 
     Scheduler& scheduler() const {
         return scheduler_;
     }
 
+    PropagationEngine& engine() {
+        return engine_;
+    }
+
+    // The recorded topology, or nullptr unless record_graph was set.
+    GraphRegistry* graph() const noexcept {
+        return graph_.get();
+    }
+
+    // Names a node in the graph registry; a no-op when it is off.
+    template <typename Node>
+    Node& name(Node& node, std::string label) const {
+        if (graph_) {
+            graph_->add_source(node);
+            graph_->set_name(node.id(), std::move(label));
+        }
+        return node;
+    }
+
+    // Applies every Signal::set made inside `fn` as one glitch-free update.
+    template <typename Fn>
+    void transaction(Fn&& fn) {
+        engine_.transaction(std::forward<Fn>(fn));
+    }
+
     template <typename T>
     Signal<T> signal(T initial) const {
-        return Signal<T>(std::move(initial));
+        return record("source", Signal<T>(std::move(initial)));
     }
 
     template <typename T>
     Stream<T> stream() const {
-        return Stream<T>();
+        return record("source", Stream<T>());
     }
 
     template <typename T, typename Fn>
     auto signal_map(Signal<T>& input, Fn&& fn) const {
-        return carl::signal_map(scheduler_, input, std::forward<Fn>(fn));
+        return record("signal_map", carl::signal_map(scheduler_, input, std::forward<Fn>(fn)), input);
     }
 
     template <typename A, typename B, typename Fn>
     auto signal_combine(Signal<A>& left, Signal<B>& right, Fn&& fn) const {
-        return carl::signal_combine(scheduler_, left, right, std::forward<Fn>(fn));
+        auto node = carl::signal_combine(scheduler_, left, right, std::forward<Fn>(fn));
+        return record("signal_combine", std::move(node), left, right);
+    }
+
+    template <typename T, typename Fn, typename Equal>
+    auto signal_map_distinct(Signal<T>& input, Fn&& fn, Equal&& equal) const {
+        auto node = carl::signal_map_distinct(scheduler_, input, std::forward<Fn>(fn), std::forward<Equal>(equal));
+        return record("signal_map_distinct", std::move(node), input);
+    }
+
+    template <typename A, typename B, typename Fn, typename Equal>
+    auto signal_combine_distinct(Signal<A>& left, Signal<B>& right, Fn&& fn, Equal&& equal) const {
+        auto node = carl::signal_combine_distinct(scheduler_, left, right, std::forward<Fn>(fn),
+                                                  std::forward<Equal>(equal));
+        return record("signal_combine_distinct", std::move(node), left, right);
+    }
+
+    template <typename T, typename Fn>
+    auto signal_map_lazy(Signal<T>& input, Fn&& fn) const {
+        return record("signal_map_lazy", carl::signal_map_lazy(input, std::forward<Fn>(fn)), input);
+    }
+
+    template <typename A, typename B, typename Fn>
+    auto signal_combine_lazy(Signal<A>& left, Signal<B>& right, Fn&& fn) const {
+        return record("signal_combine_lazy", carl::signal_combine_lazy(left, right, std::forward<Fn>(fn)), left, right);
     }
 
     template <typename T, typename Fn>
     auto stream_map(Stream<T>& input, Fn&& fn) const {
-        return carl::stream_map(scheduler_, input, std::forward<Fn>(fn));
+        return record("stream_map", carl::stream_map(scheduler_, input, std::forward<Fn>(fn)), input);
     }
 
     template <typename T, typename Pred>
     auto stream_filter(Stream<T>& input, Pred&& pred) const {
-        return carl::stream_filter(scheduler_, input, std::forward<Pred>(pred));
+        return record("stream_filter", carl::stream_filter(scheduler_, input, std::forward<Pred>(pred)), input);
+    }
+
+    template <typename T>
+    Stream<Payload<T>> stream_share(Stream<T>& input) const {
+        return record("stream_share", carl::stream_share(scheduler_, input), input);
     }
 
     template <typename T, typename Acc, typename Fn>
     auto stream_fold(Stream<T>& input, Acc seed, Fn&& fn) const {
-        return carl::stream_fold(scheduler_, input, std::move(seed), std::forward<Fn>(fn));
+        auto node = carl::stream_fold(scheduler_, input, std::move(seed), std::forward<Fn>(fn));
+        return record("stream_fold", std::move(node), input);
+    }
+
+    // Opt-in SIMD operators for arithmetic streams; see carl/simd.h.
+    template <typename T, typename Fn>
+    auto stream_map_simd(Stream<T>& input, Fn&& fn) const {
+        return record("stream_map_simd", carl::stream_map_simd(scheduler_, input, std::forward<Fn>(fn)), input);
+    }
+
+    template <typename T, typename Pred>
+    auto stream_filter_simd(Stream<T>& input, Pred&& pred) const {
+        auto node = carl::stream_filter_simd(scheduler_, input, std::forward<Pred>(pred));
+        return record("stream_filter_simd", std::move(node), input);
+    }
+
+    template <typename T>
+    auto stream_sum(Stream<T>& input) const {
+        return record("stream_sum", carl::stream_sum(scheduler_, input), input);
+    }
+
+    template <typename T>
+    auto stream_min(Stream<T>& input) const {
+        return record("stream_min", carl::stream_min(scheduler_, input), input);
+    }
+
+    template <typename T>
+    auto stream_max(Stream<T>& input) const {
+        return record("stream_max", carl::stream_max(scheduler_, input), input);
+    }
+
+    template <typename T, typename Duration>
+    auto stream_debounce(Stream<T>& input, Duration quiet) const {
+        return record("stream_debounce", carl::stream_debounce(scheduler_, input, quiet), input);
+    }
+
+    template <typename T, typename Duration>
+    auto stream_throttle(Stream<T>& input, Duration interval) const {
+        return record("stream_throttle", carl::stream_throttle(scheduler_, input, interval), input);
+    }
+
+    template <typename T, typename Duration>
+    auto stream_sample(Stream<T>& input, Duration period) const {
+        return record("stream_sample", carl::stream_sample(scheduler_, input, period), input);
+    }
+
+    template <typename T, typename Duration>
+    auto stream_buffer_time(Stream<T>& input, Duration window) const {
+        return record("stream_buffer_time", carl::stream_buffer_time(scheduler_, input, window), input);
     }
 
 private:
+    template <typename Node, typename... Inputs>
+    Node record(const char* op, Node node, Inputs&... inputs) const {
+        if (graph_) {
+            (graph_->add_source(inputs), ...);
+            graph_->add(node, op, {inputs.id()...});
+        }
+        return node;
+    }
+
     Scheduler& scheduler_;
+    PropagationEngine engine_;
+    std::unique_ptr<GraphRegistry> graph_;
 };
 
 }  // namespace carl
@@ -1,17 +1,78 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <coroutine>
+#include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include "carl/affinity.h"
+#include "carl/inline_function.h"
+#include "carl/job.h"
+#include "carl/metrics.h"
 #include "carl/task.h"
+#include "carl/timer_wheel.h"
+#include "carl/work_stealing_deque.h"
 
 namespace carl {
 
+// Spin-wait hint: tells the core it is in a busy-wait loop (PAUSE on x86,
+// YIELD on ARM), which saves power and frees the sibling hyperthread.
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+// What a worker does when it finds no work.
+enum class IdleStrategy : std::uint8_t {
+    // Sleep on the scheduler's condition variable right away.
+    park,
+    // Poll for work with pause hints and never sleep. Lowest wake-up
+    // latency, at the cost of a fully busy core per idle worker.
+    spin,
+    // Poll for spin_iterations rounds, then keep polling but give up the
+    // time slice between polls.
+    spin_yield,
+    // Poll for spin_iterations rounds, then park.
+    spin_park,
+};
+
+// A contiguous range of worker indices.
+struct WorkerGroup {
+    std::size_t first{0};
+    std::size_t count{1};
+};
+
+struct SchedulerOptions {
+    std::size_t worker_count{std::thread::hardware_concurrency()};
+    // Worker i is pinned to cpus[i % cpus.size()].
+    std::vector<int> cpus{};
+    // Workers are split into contiguous blocks, one per node, and each block
+    // is pinned to its node's CPUs. Ignored when `cpus` is set.
+    std::vector<int> numa_nodes{};
+    // A continuation scheduled from a worker goes into that worker's
+    // one-item slot and runs next there instead of being exposed to thieves;
+    // the item it displaces moves to the deque. Keeps producer/consumer
+    // ping-pong on one core and its cache.
+    bool lifo_slot{false};
+    IdleStrategy idle{IdleStrategy::park};
+    // Polling rounds before spin_yield/spin_park back off; each round is
+    // spin_pauses pause hints followed by one look for work.
+    std::uint32_t spin_iterations{128};
+    std::uint32_t spin_pauses{32};
+};
+
 class Scheduler {
 public:
     struct YieldAwaitable {
@@ -22,40 +83,178 @@ public:
         }
 
         void await_suspend(std::coroutine_handle<> handle) const {
-            scheduler->schedule(handle);
+            scheduler->schedule_global(handle);
         }
 
         void await_resume() const noexcept {}
     };
 
-    explicit Scheduler(std::size_t worker_count = std::thread::hardware_concurrency()) {
-        if (worker_count == 0) {
-            worker_count = 1;
+    using Clock = std::chrono::steady_clock;
+
+    struct SleepAwaitable {
+        Scheduler* scheduler{};
+        Clock::time_point deadline{};
+
+        bool await_ready() const {
+            return deadline <= Clock::now();
         }
+
+        void await_suspend(std::coroutine_handle<> handle) const {
+            scheduler->submit_at(deadline, [handle]() { handle.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // Suspends and resumes on one particular worker. It always yields, even
+    // when the coroutine is already running there.
+    struct ResumeOnAwaitable {
+        Scheduler* scheduler{};
+        std::size_t worker{};
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) const {
+            scheduler->schedule_on(worker, handle);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    explicit Scheduler(std::size_t worker_count = std::thread::hardware_concurrency())
+        : Scheduler(SchedulerOptions{.worker_count = worker_count}) {}
+
+    explicit Scheduler(SchedulerOptions options)
+        : lifo_slot_(options.lifo_slot),
+          idle_(options.idle),
+          spin_iterations_(options.spin_iterations),
+          spin_pauses_(options.spin_pauses) {
+        const std::size_t worker_count = options.worker_count == 0 ? 1 : options.worker_count;
         workers_.reserve(worker_count);
         for (std::size_t i = 0; i < worker_count; ++i) {
-            workers_.emplace_back([this](std::stop_token stop_token) { worker_loop(stop_token); });
+            auto worker = std::make_unique<Worker>(this, i);
+            if (!options.cpus.empty()) {
+                worker->cpus = {options.cpus[i % options.cpus.size()]};
+            } else if (!options.numa_nodes.empty()) {
+                worker->numa_node = options.numa_nodes[i * options.numa_nodes.size() / worker_count];
+                worker->cpus = numa_node_cpus(worker->numa_node);
+            }
+            workers_.push_back(std::move(worker));
+        }
+        for (auto& worker : workers_) {
+            worker->thread = std::jthread(
+                [this, raw = worker.get()](std::stop_token stop_token) { worker_loop(*raw, stop_token); });
+            if (!pin_thread(worker->thread.native_handle(), worker->cpus)) {
+                worker->cpus.clear();
+            }
         }
     }
 
     ~Scheduler() {
         for (auto& worker : workers_) {
-            worker.request_stop();
+            worker->thread.request_stop();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+        for (auto& worker : workers_) {
+            worker->thread.join();
+        }
+
+        TimerNode* node = timers_.clear();
+        while (node != nullptr) {
+            TimerNode* next = node->next_timer;
+            delete static_cast<TimerJob*>(node);
+            node = next;
         }
-        cv_.notify_all();
     }
 
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
     void schedule(std::coroutine_handle<> handle) {
+        enqueue(WorkItem::from(handle));
+    }
+
+    void schedule(Job* job) {
+        enqueue(WorkItem::from(job));
+    }
+
+    void schedule_global(std::coroutine_handle<> handle) {
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        inject(WorkItem::from(handle));
+    }
+
+    template <typename Fn>
+    void submit(Fn&& fn) {
+        schedule(make_job(std::forward<Fn>(fn)));
+    }
+
+    // Runs work on worker `worker % worker_count()` only. Pinned items sit in
+    // that worker's inbox, which other workers never steal from.
+    void schedule_on(std::size_t worker, std::coroutine_handle<> handle) {
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        push_to(*workers_[worker % workers_.size()], WorkItem::from(handle));
+    }
+
+    void schedule_on(std::size_t worker, Job* job) {
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        push_to(*workers_[worker % workers_.size()], WorkItem::from(job));
+    }
+
+    template <typename Fn>
+    void submit_on(std::size_t worker, Fn&& fn) {
+        schedule_on(worker, make_job(std::forward<Fn>(fn)));
+    }
+
+    ResumeOnAwaitable resume_on(std::size_t worker) {
+        return ResumeOnAwaitable{this, worker};
+    }
+
+    // Runs `fn` as a job once `deadline` has passed, at millisecond
+    // resolution. A pending timer counts as outstanding work for run().
+    template <typename Fn>
+    void submit_at(Clock::time_point deadline, Fn&& fn) {
+        auto* timer = new TimerJob(std::forward<Fn>(fn));
+        timer->deadline = tick_at(deadline);
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        timer_count_.fetch_add(1, std::memory_order_relaxed);
+
+        bool earliest = false;
         {
+            std::lock_guard<std::mutex> lock(timer_mutex_);
+            timers_.insert(timer);
+            const std::uint64_t next = timers_.next_expiration();
+            earliest = next < next_timer_.load(std::memory_order_relaxed);
+            next_timer_.store(next, std::memory_order_relaxed);
+        }
+        if (earliest) {
             std::lock_guard<std::mutex> lock(mutex_);
-            queue_.push_back(handle);
+            cv_.notify_all();
         }
-        cv_.notify_one();
+    }
+
+    template <typename Rep, typename Period, typename Fn>
+    void submit_after(std::chrono::duration<Rep, Period> delay, Fn&& fn) {
+        submit_at(Clock::now() + std::chrono::ceil<Clock::duration>(delay), std::forward<Fn>(fn));
+    }
+
+    template <typename Rep, typename Period>
+    SleepAwaitable sleep_for(std::chrono::duration<Rep, Period> delay) {
+        return SleepAwaitable{this, Clock::now() + std::chrono::ceil<Clock::duration>(delay)};
+    }
+
+    SleepAwaitable sleep_until(Clock::time_point deadline) {
+        return SleepAwaitable{this, deadline};
     }
 
     void spawn(Task task) {
         auto handle = task.release();
         if (handle) {
+            handle.promise().detached = true;
             schedule(handle);
         }
     }
@@ -64,51 +263,492 @@ public:
         return YieldAwaitable{this};
     }
 
+    // Blocks until no scheduled work is queued or running. Waits on the
+    // outstanding-work counter itself (a futex on Linux), so completions
+    // only pay for a wake-up when the count reaches zero.
     void run() {
-        std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait(lock, [this]() { return queue_.empty() && active_.load() == 0; });
+        std::size_t outstanding = outstanding_.load(std::memory_order_acquire);
+        while (outstanding != 0) {
+            outstanding_.wait(outstanding, std::memory_order_acquire);
+            outstanding = outstanding_.load(std::memory_order_acquire);
+        }
     }
 
     bool empty() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.empty();
+        if (has_queued_work()) {
+            return false;
+        }
+        for (const auto& worker : workers_) {
+            if (worker->inbox_size.load(std::memory_order_relaxed) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::size_t worker_count() const noexcept {
+        return workers_.size();
+    }
+
+    // Per-worker counters, live queue lengths, and every instrumented node
+    // and actor in the process. Counters and histograms read zero unless
+    // CARL_ENABLE_METRICS is set.
+    metrics::SchedulerStats stats() const {
+        metrics::SchedulerStats stats;
+        stats.workers.reserve(workers_.size());
+        for (const auto& worker : workers_) {
+            stats.workers.push_back(metrics::WorkerStats{worker->index, worker->tasks_run.load(),
+                                                         worker->steals.load(), worker->idle_ns.load(),
+                                                         worker->deque.size(),
+                                                         worker->inbox_size.load(std::memory_order_relaxed)});
+        }
+        stats.injected = injected_.load(std::memory_order_relaxed);
+        stats.outstanding = outstanding_.load(std::memory_order_relaxed);
+        stats.pending_timers = timer_count_.load(std::memory_order_relaxed);
+        stats.nodes = metrics::Registry::global().nodes();
+        stats.actors = metrics::Registry::global().actors();
+        return stats;
+    }
+
+    // Index of the calling worker, if the caller is one of this scheduler's.
+    std::optional<std::size_t> current_worker() const noexcept {
+        Worker* worker = current_worker_;
+        if (worker == nullptr || worker->scheduler != this) {
+            return std::nullopt;
+        }
+        return worker->index;
+    }
+
+    // CPUs the worker is pinned to; empty when it is not pinned.
+    const std::vector<int>& worker_cpus(std::size_t worker) const {
+        return workers_[worker % workers_.size()]->cpus;
+    }
+
+    // Workers placed on NUMA node `node` through SchedulerOptions::numa_nodes,
+    // or every worker if none are.
+    WorkerGroup numa_group(int node) const {
+        WorkerGroup group{0, 0};
+        for (const auto& worker : workers_) {
+            if (worker->numa_node != node) {
+                continue;
+            }
+            if (group.count == 0) {
+                group.first = worker->index;
+            }
+            ++group.count;
+        }
+        if (group.count == 0) {
+            return WorkerGroup{0, workers_.size()};
+        }
+        return group;
     }
 
 private:
-    void worker_loop(std::stop_token stop_token) {
+    static constexpr std::uint32_t global_queue_interval = 61;
+    // Consecutive runs from the LIFO slot before its item is made stealable.
+    static constexpr std::uint32_t lifo_streak_limit = 3;
+
+    // A coroutine handle or a Job, told apart by the low address bit (both
+    // are at least pointer-aligned), so the deques stay one word per entry.
+    class WorkItem {
+    public:
+        WorkItem() = default;
+
+        static WorkItem from(std::coroutine_handle<> handle) {
+            return WorkItem(reinterpret_cast<std::uintptr_t>(handle.address()));
+        }
+
+        static WorkItem from(Job* job) {
+            return WorkItem(reinterpret_cast<std::uintptr_t>(job) | job_tag);
+        }
+
+        void run() const {
+            if ((bits_ & job_tag) != 0) {
+                reinterpret_cast<Job*>(bits_ & ~job_tag)->run();
+            } else {
+                std::coroutine_handle<>::from_address(reinterpret_cast<void*>(bits_)).resume();
+            }
+        }
+
+    private:
+        static constexpr std::uintptr_t job_tag = 1;
+
+        explicit WorkItem(std::uintptr_t bits) : bits_(bits) {}
+
+        std::uintptr_t bits_{0};
+    };
+
+    class TimerJob final : public Job, public TimerNode, public PoolAllocated {
+    public:
+        template <typename Fn>
+        explicit TimerJob(Fn&& fn) : Job(&TimerJob::execute), fn_(std::forward<Fn>(fn)) {}
+
+    private:
+        static void execute(Job* job) {
+            auto* self = static_cast<TimerJob*>(job);
+            self->fn_();
+            delete self;
+        }
+
+        InlineFunction<void()> fn_;
+    };
+
+    struct Worker {
+        Worker(Scheduler* owner, std::size_t worker_index)
+            : scheduler(owner), index(worker_index), rng_state(0x9E3779B97F4A7C15ull * (worker_index + 1)) {}
+
+        Scheduler* scheduler;
+        std::size_t index;
+        std::uint64_t rng_state;
+        std::uint32_t tick{0};
+        WorkStealingDeque<WorkItem> deque{};
+        std::jthread thread{};
+        std::vector<int> cpus{};
+        int numa_node{-1};
+
+        // Owner-only LIFO slot (SchedulerOptions::lifo_slot).
+        WorkItem lifo{};
+        bool has_lifo{false};
+        std::uint32_t lifo_streak{0};
+
+        // Work pinned to this worker by schedule_on().
+        std::mutex inbox_mutex{};
+        std::deque<WorkItem> inbox{};
+        std::atomic<std::size_t> inbox_size{0};
+        std::atomic<bool> sleeping{false};
+
+        metrics::Counter tasks_run{};
+        metrics::Counter steals{};
+        metrics::Counter idle_ns{};
+    };
+
+    void worker_loop(Worker& worker, std::stop_token stop_token) {
+        current_worker_ = &worker;
         while (true) {
-            std::coroutine_handle<> handle;
-            {
-                std::unique_lock<std::mutex> lock(mutex_);
-                cv_.wait(lock, [this, &stop_token]() {
-                    return stop_token.stop_requested() || !queue_.empty();
-                });
-
-                if (stop_token.stop_requested() && queue_.empty()) {
+            WorkItem item;
+            if (!find_work(worker, item)) {
+                const metrics::Timestamp idle_since{};
+                const bool found = spin_for_work(worker, item, stop_token);
+                if (!found && (idle_ == IdleStrategy::spin || idle_ == IdleStrategy::spin_yield)) {
+                    break;
+                }
+                const bool keep_running = found || wait_for_work(worker, stop_token);
+                worker.idle_ns.add(idle_since.elapsed_ns());
+                if (!keep_running) {
+                    break;
+                }
+                if (!found) {
+                    continue;
+                }
+            }
+
+            item.run();
+            worker.tasks_run.add();
+            complete_one();
+        }
+        current_worker_ = nullptr;
+    }
+
+    void enqueue(WorkItem item) {
+        outstanding_.fetch_add(1, std::memory_order_relaxed);
+        push_ready(item);
+    }
+
+    // Queues an item whose outstanding unit has already been counted.
+    void push_ready(WorkItem item) {
+        Worker* worker = current_worker_;
+        if (worker != nullptr && worker->scheduler == this) {
+            if (lifo_slot_) {
+                if (!worker->has_lifo) {
+                    worker->lifo = item;
+                    worker->has_lifo = true;
                     return;
                 }
+                item = std::exchange(worker->lifo, item);
+            }
+            worker->deque.push(item);
+            wake_one();
+            return;
+        }
+
+        inject(item);
+    }
+
+    // Only the target may be able to run the item, so a sleeping target is
+    // woken even if that also wakes idle workers that go back to sleep.
+    void push_to(Worker& worker, WorkItem item) {
+        {
+            std::lock_guard<std::mutex> lock(worker.inbox_mutex);
+            worker.inbox.push_back(item);
+            worker.inbox_size.store(worker.inbox.size(), std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (worker.sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+    }
 
-                handle = queue_.front();
-                queue_.pop_front();
-                active_.fetch_add(1);
+    static bool pop_inbox(Worker& worker, WorkItem& out) {
+        if (worker.inbox_size.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(worker.inbox_mutex);
+        if (worker.inbox.empty()) {
+            return false;
+        }
+        out = worker.inbox.front();
+        worker.inbox.pop_front();
+        worker.inbox_size.store(worker.inbox.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    // Runs the slot's item unless it has already run lifo_streak_limit
+    // times in a row; then it goes to the deque, where thieves can see it.
+    bool pop_lifo(Worker& worker, WorkItem& out) {
+        if (!worker.has_lifo) {
+            worker.lifo_streak = 0;
+            return false;
+        }
+        worker.has_lifo = false;
+        if (worker.lifo_streak++ < lifo_streak_limit) {
+            out = worker.lifo;
+            return true;
+        }
+        worker.lifo_streak = 0;
+        worker.deque.push(worker.lifo);
+        wake_one();
+        return false;
+    }
+
+    // A worker registers in sleeping_ under mutex_ before it re-checks the
+    // queue, so a push that sees no sleepers can skip the notify.
+    void inject(WorkItem item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            injection_.push_back(item);
+            injected_.store(injection_.size(), std::memory_order_relaxed);
+        }
+        if (sleeping_.load(std::memory_order_relaxed) > 0) {
+            cv_.notify_one();
+        }
+    }
+
+    bool pop_injected(WorkItem& out) {
+        if (injected_.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (injection_.empty()) {
+            return false;
+        }
+        out = injection_.front();
+        injection_.pop_front();
+        injected_.store(injection_.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    // The injection queue and the inbox are checked first every few ticks so
+    // that a worker whose local deque keeps refilling cannot starve
+    // externally queued or pinned work.
+    bool find_work(Worker& worker, WorkItem& out) {
+        if (++worker.tick % global_queue_interval == 0) {
+            poll_timers();
+            if (pop_injected(out) || pop_inbox(worker, out)) {
+                return true;
             }
+        }
+        if (pop_lifo(worker, out)) {
+            return true;
+        }
+        if (worker.deque.pop(out)) {
+            return true;
+        }
+        if (pop_inbox(worker, out)) {
+            return true;
+        }
+        poll_timers();
+        if (pop_lifo(worker, out) || worker.deque.pop(out)) {
+            return true;
+        }
+        if (pop_injected(out)) {
+            return true;
+        }
+        return steal(worker, out);
+    }
+
+    // Polls according to the idle strategy. Returns false when the worker
+    // should park (spin_park, park) or stop (spin, spin_yield once stop is
+    // requested and nothing is left for it).
+    bool spin_for_work(Worker& worker, WorkItem& out, const std::stop_token& stop_token) {
+        if (idle_ == IdleStrategy::park) {
+            return false;
+        }
+        for (std::uint32_t round = 0;; ++round) {
+            if (stop_token.stop_requested()) {
+                return find_work(worker, out);
+            }
+            if (round < spin_iterations_ || idle_ == IdleStrategy::spin) {
+                for (std::uint32_t i = 0; i < spin_pauses_; ++i) {
+                    cpu_relax();
+                }
+            } else if (idle_ == IdleStrategy::spin_yield) {
+                std::this_thread::yield();
+            } else {
+                return false;
+            }
+            if (find_work(worker, out)) {
+                return true;
+            }
+        }
+    }
 
-            handle.resume();
+    std::uint64_t tick_at(Clock::time_point time) const {
+        const auto elapsed = std::chrono::ceil<std::chrono::milliseconds>(time - epoch_).count();
+        return elapsed > 0 ? static_cast<std::uint64_t>(elapsed) : 0;
+    }
 
-            if (handle.done()) {
-                handle.destroy();
+    Clock::time_point time_at(std::uint64_t tick) const {
+        return epoch_ + std::chrono::milliseconds(tick);
+    }
+
+    // Moves expired timers onto this worker's deque. Workers poll on their
+    // way to stealing and every global_queue_interval ticks; the cost is one
+    // atomic load unless a timer is actually due.
+    void poll_timers() {
+        if (timer_count_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        const std::uint64_t now = std::chrono::floor<std::chrono::milliseconds>(Clock::now() - epoch_).count();
+        if (now < next_timer_.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        TimerNode* expired = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(timer_mutex_, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                return;
             }
+            expired = timers_.advance(now);
+            next_timer_.store(timers_.next_expiration(), std::memory_order_relaxed);
+        }
+        while (expired != nullptr) {
+            TimerNode* next = expired->next_timer;
+            timer_count_.fetch_sub(1, std::memory_order_relaxed);
+            push_ready(WorkItem::from(static_cast<Job*>(static_cast<TimerJob*>(expired))));
+            expired = next;
+        }
+    }
 
-            active_.fetch_sub(1);
-            cv_.notify_all();
+    bool steal(Worker& thief, WorkItem& out) {
+        const std::size_t count = workers_.size();
+        if (count < 2) {
+            return false;
         }
+
+        thief.rng_state ^= thief.rng_state << 13;
+        thief.rng_state ^= thief.rng_state >> 7;
+        thief.rng_state ^= thief.rng_state << 17;
+        const std::size_t start = static_cast<std::size_t>(thief.rng_state % count);
+
+        for (std::size_t offset = 0; offset < count; ++offset) {
+            Worker& victim = *workers_[(start + offset) % count];
+            if (&victim != &thief && victim.deque.steal(out)) {
+                thief.steals.add();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // One sleeping worker at a time keeps time: it waits until the next timer
+    // deadline while the others wait for queued work. submit_at() wakes them
+    // all when it adds a new earliest deadline.
+    bool wait_for_work(Worker& worker, const std::stop_token& stop_token) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        worker.sleeping.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!stop_token.stop_requested() && !has_queued_work(worker)) {
+            if (timer_count_.load(std::memory_order_relaxed) == 0 || timekeeper_) {
+                cv_.wait(lock);
+                continue;
+            }
+            const std::uint64_t next = next_timer_.load(std::memory_order_relaxed);
+            if (next != TimerWheel::never && Clock::now() >= time_at(next)) {
+                break;
+            }
+            timekeeper_ = true;
+            if (next == TimerWheel::never) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, time_at(next));
+            }
+            timekeeper_ = false;
+        }
+        worker.sleeping.store(false, std::memory_order_relaxed);
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        if (!timekeeper_ && timer_count_.load(std::memory_order_relaxed) != 0) {
+            cv_.notify_one();
+        }
+        return has_queued_work(worker) || !stop_token.stop_requested();
+    }
+
+    // Shared work plus whatever is pinned to `worker`.
+    bool has_queued_work(const Worker& worker) const {
+        return worker.inbox_size.load(std::memory_order_relaxed) != 0 || has_queued_work();
+    }
+
+    // Called with mutex_ held, so the injection queue is stable; worker deques
+    // are inspected racily, which is fine because pushers re-check sleeping_.
+    bool has_queued_work() const {
+        if (!injection_.empty()) {
+            return true;
+        }
+        for (const auto& worker : workers_) {
+            if (!worker->deque.empty()) {
+                return true;
+            }
+        }
+        return false;
     }
 
+    void wake_one() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+    }
+
+    void complete_one() {
+        if (outstanding_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            outstanding_.notify_all();
+        }
+    }
+
+    inline static thread_local Worker* current_worker_ = nullptr;
+
     mutable std::mutex mutex_{};
     std::condition_variable cv_{};
-    std::deque<std::coroutine_handle<>> queue_{};
-    std::atomic<std::size_t> active_{0};
-    std::vector<std::jthread> workers_{};
+    std::deque<WorkItem> injection_{};
+    std::atomic<std::size_t> injected_{0};
+    std::atomic<std::size_t> outstanding_{0};
+    std::atomic<std::size_t> sleeping_{0};
+    bool timekeeper_{false};
+    const bool lifo_slot_;
+    const IdleStrategy idle_;
+    const std::uint32_t spin_iterations_;
+    const std::uint32_t spin_pauses_;
+    std::vector<std::unique_ptr<Worker>> workers_{};
+
+    const Clock::time_point epoch_{Clock::now()};
+    std::mutex timer_mutex_{};
+    TimerWheel timers_{};
+    std::atomic<std::uint64_t> next_timer_{TimerWheel::never};
+    std::atomic<std::size_t> timer_count_{0};
 };
 
 }  // namespace carl
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -8,94 +15,351 @@
 #include <utility>
 #include <vector>
 
+#include "carl/metrics.h"
+#include "carl/observer_list.h"
+#include "carl/propagation.h"
 #include "carl/scheduler.h"
+#include "carl/strand.h"
 #include "carl/subscription.h"
-#include "carl/task.h"
+#include "carl/trace.h"
+#include "carl/versioned_value.h"
 
 namespace carl {
 
+// Comparator for floating-point signals: values within `epsilon` of the
+// current one are treated as unchanged.
+template <std::floating_point T>
+auto approx_equal(T epsilon) {
+    return [epsilon](const T& left, const T& right) { return std::abs(left - right) <= epsilon; };
+}
+
+// Comparator that never reports a value as unchanged, so every set notifies.
+inline constexpr auto always_notify = [](const auto&, const auto&) { return false; };
+
 template <typename T>
 class Signal {
 public:
     using Callback = std::function<void(const T&)>;
+    // Decides whether a new value equals the current one; set() skips
+    // propagation when it does. Defaults to operator== when T has one.
+    using Equal = std::function<bool(const T&, const T&)>;
+
+    // Values that are trivially copyable and fit a cache line are stored
+    // inline, behind a seqlock. Anything else is held as an immutable
+    // Payload: set() stores it once and every observer, scheduled dispatch
+    // and value_ref() shares it. Either way value() does not take a lock.
+    static constexpr bool shares_value = !stores_inline<T>;
+
+    static Equal default_equal() {
+        if constexpr (std::equality_comparable<T>) {
+            return std::equal_to<T>{};
+        } else {
+            return {};
+        }
+    }
 
     Signal() = delete;
-    explicit Signal(T initial)
-        : state_(std::make_shared<State>(std::move(initial))),
+    explicit Signal(T initial) : Signal(std::move(initial), default_equal()) {}
+    Signal(T initial, Equal equal)
+        : state_(std::make_shared<State>(std::move(initial), std::move(equal))),
           ownership_(std::make_shared<Ownership>()) {}
 
     T value() const {
-        std::lock_guard<std::mutex> lock(state_->mutex);
-        return state_->value;
+        return view(load());
+    }
+
+    // Calls fn(const T&) with the current value and returns its result. The
+    // value is not copied when the signal shares it, and fn may read or set
+    // signals itself.
+    template <typename Fn>
+    decltype(auto) read(Fn&& fn) const {
+        const Stored current = load();
+        return std::forward<Fn>(fn)(view(current));
+    }
+
+    // The current value as a shared handle that stays valid (and unchanged)
+    // across later sets.
+    Payload<T> value_ref() const
+        requires shares_value
+    {
+        return load();
+    }
+
+    // Bumped by every stored change. A node that remembers the versions of
+    // its inputs can skip recomputing when none of them moved. A dirty lazy
+    // node gets a new version once it is recomputed.
+    std::uint64_t version() const noexcept {
+        return state_->value.version();
     }
 
     void set(T value) {
-        std::vector<Callback> callbacks;
-        T current;
-        {
-            std::lock_guard<std::mutex> lock(state_->mutex);
-            state_->value = std::move(value);
-            current = state_->value;
-            callbacks = state_->observers;
+        if (auto* batch = WriteBatch::current()) {
+            record_write(*batch, std::move(value));
+            return;
+        }
+        if (auto* propagation = Propagation::current()) {
+            set_deferred(*propagation, std::move(value));
+            return;
         }
 
-        for (const auto& callback : callbacks) {
-            if (callback) {
-                callback(current);
+        Stored current;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->dirty.store(false, std::memory_order_relaxed);
+            if (unchanged(value)) {
+                return;
             }
+            current = state_->value.store(std::move(value));
         }
+
+        trace::Scope scope("signal.set");
+        state_->metrics.emits.add();
+        metrics::ScopedTimer timer(state_->metrics.callback_time);
+        dispatch_callbacks(*state_->observers.snapshot(), view(current));
+        notify_dependents(*state_);
     }
 
     void set(Scheduler& scheduler, T value) {
-        std::vector<Callback> callbacks;
-        T current;
+        if (auto* batch = WriteBatch::current()) {
+            record_write(*batch, std::move(value));
+            return;
+        }
+        if (auto* propagation = Propagation::current()) {
+            set_deferred(*propagation, std::move(value));
+            return;
+        }
+
         {
+            // Posting under the lock keeps notifications in the same order as
+            // the stores when several threads set concurrently.
             std::lock_guard<std::mutex> lock(state_->mutex);
-            state_->value = std::move(value);
-            current = state_->value;
-            callbacks = state_->observers;
+            state_->dirty.store(false, std::memory_order_relaxed);
+            if (unchanged(value)) {
+                return;
+            }
+            state_->metrics.emits.add();
+            state_->strand.get(scheduler).post([callbacks = state_->observers.snapshot(),
+                                                node = metrics::node_ref(state_), hop = trace::Hop("signal.set"),
+                                                payload = state_->value.store(std::move(value))]() {
+                trace::Scope scope("signal.dispatch", hop);
+                metrics::ScopedTimer timer(metrics::callback_histogram(node));
+                dispatch_callbacks(*callbacks, view(payload));
+            });
         }
 
-        scheduler.spawn(dispatch_callbacks(std::move(callbacks), std::move(current)));
+        notify_dependents(*state_);
     }
 
     Subscription subscribe(Callback callback) {
-        std::lock_guard<std::mutex> lock(state_->mutex);
-        const std::size_t index = state_->observers.size();
-        state_->observers.emplace_back(std::move(callback));
+        const auto handle = state_->observers.add(std::move(callback));
 
         std::weak_ptr<State> weak_state = state_;
-        return Subscription([weak_state, index]() {
+        return Subscription([weak_state, handle]() {
             if (auto shared_state = weak_state.lock()) {
-                std::lock_guard<std::mutex> guard(shared_state->mutex);
-                if (index < shared_state->observers.size()) {
-                    shared_state->observers[index] = nullptr;
-                }
+                shared_state->observers.remove(handle);
             }
         });
     }
 
+    // Registers a callback that runs whenever this signal may have changed,
+    // without reading the value. Lazy nodes use it to track their inputs
+    // without forcing them to recompute.
+    Subscription on_invalidate(std::function<void()> callback) {
+        const auto handle = state_->dependents.add(std::move(callback));
+
+        std::weak_ptr<State> weak_state = state_;
+        return Subscription([weak_state, handle]() {
+            if (auto shared_state = weak_state.lock()) {
+                shared_state->dependents.remove(handle);
+            }
+        });
+    }
+
+    // Turns this signal into a lazy node computed by `pull`. Once an input
+    // changes, invalidate() only marks it dirty; the value is recomputed
+    // (and memoized) on the next value() call, or right away when the
+    // signal has observers that need to be notified.
+    void compute_with(std::function<T()> pull) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->pull = std::move(pull);
+    }
+
+    void invalidate() {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (!state_->pull) {
+                return;
+            }
+            state_->dirty.store(true, std::memory_order_release);
+        }
+
+        if (state_->observers.size() == 0) {
+            notify_dependents(*state_);
+            return;
+        }
+        if (auto* propagation = Propagation::current()) {
+            propagation->defer(state_->rank, Propagation::Phase::recompute, state_.get(),
+                               [state = state_]() { refresh(state); });
+        } else {
+            refresh(state_);
+        }
+    }
+
+    bool dirty() const {
+        return state_->dirty.load(std::memory_order_acquire);
+    }
+
     void keep_alive(Subscription subscription) {
         std::lock_guard<std::mutex> lock(ownership_->mutex);
         ownership_->subscriptions.emplace_back(std::move(subscription));
     }
 
+    // Topological rank: 0 for sources, otherwise one more than the highest
+    // ranked input. A Propagation settles nodes in rank order.
+    std::size_t rank() const noexcept {
+        return state_->rank;
+    }
+
+    template <typename U>
+    void depends_on(const Signal<U>& input) {
+        state_->rank = std::max(state_->rank, input.rank() + 1);
+    }
+
+    const void* id() const noexcept {
+        return state_.get();
+    }
+
+    // Reads the node's live stats without keeping it alive; empty once the
+    // node is gone. Emit counts and callback times need CARL_ENABLE_METRICS.
+    std::function<std::optional<metrics::NodeStats>()> probe() const {
+        return [weak = std::weak_ptr<State>(state_)]() -> std::optional<metrics::NodeStats> {
+            const auto state = weak.lock();
+            if (!state) {
+                return std::nullopt;
+            }
+            return metrics::NodeStats{"signal", reinterpret_cast<std::uintptr_t>(state.get()),
+                                      state->metrics.emits.load(), state->observers.size(),
+                                      state->metrics.callback_time.snapshot()};
+        };
+    }
+
 private:
-    static Task dispatch_callbacks(std::vector<Callback> callbacks, T value) {
-        for (const auto& callback : callbacks) {
-            if (callback) {
-                callback(value);
+    using Observers = ObserverList<Callback>;
+    using DependentList = ObserverList<std::function<void()>>;
+
+    static void dispatch_callbacks(const typename Observers::Snapshot& callbacks, const T& value) {
+        Observers::notify(callbacks, value);
+    }
+
+    void record_write(WriteBatch& batch, T value) {
+        batch.record([signal = *this, payload = std::move(value)]() mutable { signal.set(std::move(payload)); });
+    }
+
+    using Stored = typename VersionedValue<T>::Snapshot;
+
+    static const T& view(const Stored& stored) noexcept {
+        if constexpr (shares_value) {
+            return *stored;
+        } else {
+            return stored;
+        }
+    }
+
+    // The current value, recomputing a dirty lazy node first. Only that
+    // recomputation takes the lock; otherwise this is a seqlock read or an
+    // atomic snapshot load.
+    Stored load() const {
+        if (state_->dirty.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->dirty.load(std::memory_order_relaxed)) {
+                state_->dirty.store(false, std::memory_order_relaxed);
+                T next = state_->pull();
+                // Like refresh(): an equal result keeps the stored value and
+                // its version.
+                if (!unchanged(next)) {
+                    return state_->value.store(std::move(next));
+                }
+            }
+        }
+        return state_->value.load();
+    }
+
+    struct State;
+
+    static void notify_dependents(const State& state) {
+        DependentList::notify(*state.dependents.snapshot());
+    }
+
+    // Recomputes an observed lazy node and publishes the result. The dirty
+    // flag is cleared before pulling, so an input that changes meanwhile
+    // schedules another refresh instead of being lost.
+    static void refresh(const std::shared_ptr<State>& state) {
+        std::function<T()> pull;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->dirty.load(std::memory_order_relaxed)) {
+                return;
+            }
+            state->dirty.store(false, std::memory_order_relaxed);
+            pull = state->pull;
+        }
+
+        T next = pull();
+        Stored current;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->equal && state->equal(view(state->value.load()), next)) {
+                return;
             }
+            current = state->value.store(std::move(next));
         }
-        co_return;
+
+        state->metrics.emits.add();
+        metrics::ScopedTimer timer(state->metrics.callback_time);
+        dispatch_callbacks(*state->observers.snapshot(), view(current));
+        notify_dependents(*state);
+    }
+
+    // Called with the state mutex held.
+    bool unchanged(const T& value) const {
+        return state_->equal && state_->equal(view(state_->value.load()), value);
+    }
+
+    void set_deferred(Propagation& propagation, T value) {
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->dirty.store(false, std::memory_order_relaxed);
+            if (unchanged(value)) {
+                return;
+            }
+            state_->value.store(std::move(value));
+        }
+
+        propagation.defer(state_->rank, Propagation::Phase::notify, state_.get(), [state = state_]() {
+            const Stored current = state->value.load();
+            state->metrics.emits.add();
+            metrics::ScopedTimer timer(state->metrics.callback_time);
+            dispatch_callbacks(*state->observers.snapshot(), view(current));
+            notify_dependents(*state);
+        });
     }
 
     struct State {
-        explicit State(T initial) : value(std::move(initial)) {}
+        State(T initial, Equal comparator)
+            : value(std::move(initial)),
+              equal(std::move(comparator)),
+              metrics("signal", [this]() { return observers.size(); }) {}
 
-        T value;
+        VersionedValue<T> value;
+        Equal equal;
         std::mutex mutex;
-        std::vector<Callback> observers;
+        Observers observers;
+        DependentList dependents;
+        NodeStrand strand;
+        std::function<T()> pull;
+        std::atomic<bool> dirty{false};
+        std::size_t rank{0};
+        metrics::NodeMetrics metrics;
     };
 
     struct Ownership {
@@ -107,13 +371,62 @@ private:
     std::shared_ptr<Ownership> ownership_{};
 };
 
+// Runs a derived node's update now or, while a Propagation is in progress,
+// defers it to the node's rank so it runs once after its inputs settle.
+template <typename Node, typename... Args>
+void update_derived(std::size_t rank, const void* id, const std::shared_ptr<Node>& node, const Args&... args) {
+    if (auto* propagation = Propagation::current()) {
+        propagation->defer(rank, Propagation::Phase::recompute, id, [node, args...]() { (*node)(args...); });
+    } else {
+        (*node)(args...);
+    }
+}
+
+// Input versions a derived node last recomputed from. A trigger that finds
+// none of them moved -- a scheduled notification overtaken by a later one
+// that already recomputed -- is skipped.
+template <std::size_t N>
+class InputVersions {
+public:
+    explicit InputVersions(const std::array<std::uint64_t, N>& initial) noexcept {
+        for (std::size_t i = 0; i < N; ++i) {
+            seen_[i].store(initial[i], std::memory_order_relaxed);
+        }
+    }
+
+    // Records `current` and reports whether it differs from the last one.
+    // Read the versions before the values, so the values are at least as
+    // recent as what is recorded here.
+    bool advance(const std::array<std::uint64_t, N>& current) noexcept {
+        bool changed = false;
+        for (std::size_t i = 0; i < N; ++i) {
+            changed |= seen_[i].exchange(current[i], std::memory_order_relaxed) != current[i];
+        }
+        return changed;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, N> seen_{};
+};
+
 template <typename T, typename Fn>
-auto signal_map(Signal<T>& input, Fn&& fn) {
-    using Result = std::invoke_result_t<Fn, const T&>;
-    Signal<Result> output(fn(input.value()));
+using MapResult = std::invoke_result_t<Fn, const T&>;
+
+template <typename A, typename B, typename Fn>
+using CombineResult = std::invoke_result_t<Fn, const A&, const B&>;
+
+// The *_distinct variants take the comparator for the derived node, so an
+// unchanged result (for example after clamping or rounding) stops
+// propagating at that node. The plain variants use Signal's default.
+template <typename T, typename Fn>
+auto signal_map_distinct(Signal<T>& input, Fn&& fn, typename Signal<MapResult<T, Fn>>::Equal equal) {
+    Signal<MapResult<T, Fn>> output(fn(input.value()), std::move(equal));
+    output.depends_on(input);
 
-    auto update = [output, func = std::forward<Fn>(fn)](const T& value) mutable {
-        output.set(func(value));
+    auto node = std::make_shared<std::function<void(const T&)>>(
+        [output, func = std::forward<Fn>(fn)](const T& value) mutable { output.set(func(value)); });
+    auto update = [node, rank = output.rank(), id = output.id()](const T& value) {
+        update_derived(rank, id, node, value);
     };
 
     output.keep_alive(input.subscribe(std::move(update)));
@@ -121,12 +434,17 @@ auto signal_map(Signal<T>& input, Fn&& fn) {
 }
 
 template <typename T, typename Fn>
-auto signal_map(Scheduler& scheduler, Signal<T>& input, Fn&& fn) {
-    using Result = std::invoke_result_t<Fn, const T&>;
-    Signal<Result> output(fn(input.value()));
+auto signal_map_distinct(Scheduler& scheduler, Signal<T>& input, Fn&& fn,
+                         typename Signal<MapResult<T, Fn>>::Equal equal) {
+    Signal<MapResult<T, Fn>> output(fn(input.value()), std::move(equal));
+    output.depends_on(input);
 
-    auto update = [output, &scheduler, func = std::forward<Fn>(fn)](const T& value) mutable {
-        output.set(scheduler, func(value));
+    auto node = std::make_shared<std::function<void(const T&)>>(
+        [output, &scheduler, func = std::forward<Fn>(fn)](const T& value) mutable {
+            output.set(scheduler, func(value));
+        });
+    auto update = [node, rank = output.rank(), id = output.id()](const T& value) {
+        update_derived(rank, id, node, value);
     };
 
     output.keep_alive(input.subscribe(std::move(update)));
@@ -134,12 +452,21 @@ auto signal_map(Scheduler& scheduler, Signal<T>& input, Fn&& fn) {
 }
 
 template <typename A, typename B, typename Fn>
-auto signal_combine(Signal<A>& left, Signal<B>& right, Fn&& fn) {
-    using Result = std::invoke_result_t<Fn, const A&, const B&>;
-    Signal<Result> output(fn(left.value(), right.value()));
+auto signal_combine_distinct(Signal<A>& left, Signal<B>& right, Fn&& fn,
+                             typename Signal<CombineResult<A, B, Fn>>::Equal equal) {
+    auto versions = std::make_shared<InputVersions<2>>(std::array{left.version(), right.version()});
+    Signal<CombineResult<A, B, Fn>> output(fn(left.value(), right.value()), std::move(equal));
+    output.depends_on(left);
+    output.depends_on(right);
 
-    auto update = [output, &left, &right, func = std::forward<Fn>(fn)](const auto&) mutable {
-        output.set(func(left.value(), right.value()));
+    auto node = std::make_shared<std::function<void()>>(
+        [output, &left, &right, versions, func = std::forward<Fn>(fn)]() mutable {
+            if (versions->advance({left.version(), right.version()})) {
+                output.set(func(left.value(), right.value()));
+            }
+        });
+    auto update = [node, rank = output.rank(), id = output.id()](const auto&) {
+        update_derived(rank, id, node);
     };
 
     output.keep_alive(left.subscribe(update));
@@ -148,12 +475,21 @@ auto signal_combine(Signal<A>& left, Signal<B>& right, Fn&& fn) {
 }
 
 template <typename A, typename B, typename Fn>
-auto signal_combine(Scheduler& scheduler, Signal<A>& left, Signal<B>& right, Fn&& fn) {
-    using Result = std::invoke_result_t<Fn, const A&, const B&>;
-    Signal<Result> output(fn(left.value(), right.value()));
+auto signal_combine_distinct(Scheduler& scheduler, Signal<A>& left, Signal<B>& right, Fn&& fn,
+                             typename Signal<CombineResult<A, B, Fn>>::Equal equal) {
+    auto versions = std::make_shared<InputVersions<2>>(std::array{left.version(), right.version()});
+    Signal<CombineResult<A, B, Fn>> output(fn(left.value(), right.value()), std::move(equal));
+    output.depends_on(left);
+    output.depends_on(right);
 
-    auto update = [output, &scheduler, &left, &right, func = std::forward<Fn>(fn)](const auto&) mutable {
-        output.set(scheduler, func(left.value(), right.value()));
+    auto node = std::make_shared<std::function<void()>>(
+        [output, &scheduler, &left, &right, versions, func = std::forward<Fn>(fn)]() mutable {
+            if (versions->advance({left.version(), right.version()})) {
+                output.set(scheduler, func(left.value(), right.value()));
+            }
+        });
+    auto update = [node, rank = output.rank(), id = output.id()](const auto&) {
+        update_derived(rank, id, node);
     };
 
     output.keep_alive(left.subscribe(update));
@@ -161,4 +497,50 @@ auto signal_combine(Scheduler& scheduler, Signal<A>& left, Signal<B>& right, Fn&
     return output;
 }
 
+// Lazy variants: the derived node is only marked dirty when an input
+// changes and recomputes when read or observed. Like signal_combine, the
+// node refers to its inputs, which must outlive it.
+template <typename T, typename Fn>
+auto signal_map_lazy(Signal<T>& input, Fn&& fn) {
+    Signal<MapResult<T, Fn>> output(fn(input.value()));
+    output.depends_on(input);
+    output.compute_with([&input, func = std::forward<Fn>(fn)]() mutable { return func(input.value()); });
+    output.keep_alive(input.on_invalidate([output]() mutable { output.invalidate(); }));
+    return output;
+}
+
+template <typename A, typename B, typename Fn>
+auto signal_combine_lazy(Signal<A>& left, Signal<B>& right, Fn&& fn) {
+    Signal<CombineResult<A, B, Fn>> output(fn(left.value(), right.value()));
+    output.depends_on(left);
+    output.depends_on(right);
+    output.compute_with(
+        [&left, &right, func = std::forward<Fn>(fn)]() mutable { return func(left.value(), right.value()); });
+    output.keep_alive(left.on_invalidate([output]() mutable { output.invalidate(); }));
+    output.keep_alive(right.on_invalidate([output]() mutable { output.invalidate(); }));
+    return output;
+}
+
+template <typename T, typename Fn>
+auto signal_map(Signal<T>& input, Fn&& fn) {
+    return signal_map_distinct(input, std::forward<Fn>(fn), Signal<MapResult<T, Fn>>::default_equal());
+}
+
+template <typename T, typename Fn>
+auto signal_map(Scheduler& scheduler, Signal<T>& input, Fn&& fn) {
+    return signal_map_distinct(scheduler, input, std::forward<Fn>(fn), Signal<MapResult<T, Fn>>::default_equal());
+}
+
+template <typename A, typename B, typename Fn>
+auto signal_combine(Signal<A>& left, Signal<B>& right, Fn&& fn) {
+    return signal_combine_distinct(left, right, std::forward<Fn>(fn),
+                                   Signal<CombineResult<A, B, Fn>>::default_equal());
+}
+
+template <typename A, typename B, typename Fn>
+auto signal_combine(Scheduler& scheduler, Signal<A>& left, Signal<B>& right, Fn&& fn) {
+    return signal_combine_distinct(scheduler, left, right, std::forward<Fn>(fn),
+                                   Signal<CombineResult<A, B, Fn>>::default_equal());
+}
+
 }  // namespace carl
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#if __has_include(<experimental/simd>)
+#include <experimental/simd>
+#define CARL_HAS_SIMD 1
+#else
+#define CARL_HAS_SIMD 0
+#endif
+
+namespace carl {
+
+template <typename T>
+concept SimdElement = std::is_arithmetic_v<T> && !std::same_as<T, bool>;
+
+// Data-parallel kernels for batches of arithmetic values. They use the
+// native vector width of the target (std::experimental::native_simd), so the
+// instruction set is chosen at build time: configure with
+// -DCARL_NATIVE_ARCH=ON to get AVX2/AVX-512 on the build host. Without
+// <experimental/simd> every kernel falls back to a scalar loop.
+//
+// Map functions and predicates are called with a vector and with a scalar
+// (for the tail), so they are usually generic lambdas: [](auto x) { ... }.
+namespace simd {
+
+#if CARL_HAS_SIMD
+namespace stdx = std::experimental;
+
+template <typename T>
+using Vector = stdx::native_simd<T>;
+
+template <typename T>
+inline constexpr std::size_t width = Vector<T>::size();
+#else
+template <typename T>
+inline constexpr std::size_t width = 1;
+#endif
+
+template <SimdElement T, typename Fn>
+void transform(std::span<const T> input, std::span<T> output, Fn& fn) {
+    std::size_t i = 0;
+#if CARL_HAS_SIMD
+    for (; i + width<T> <= input.size(); i += width<T>) {
+        const Vector<T> chunk(input.data() + i, stdx::element_aligned);
+        const Vector<T> result = fn(chunk);
+        result.copy_to(output.data() + i, stdx::element_aligned);
+    }
+#endif
+    for (; i < input.size(); ++i) {
+        output[i] = fn(input[i]);
+    }
+}
+
+// Stream compaction: appends the elements that satisfy `pred` to `output`,
+// preserving order. Whole vectors are tested at once; chunks where every or
+// no lane passes are copied or skipped without a per-element branch.
+template <SimdElement T, typename Pred>
+void compress(std::span<const T> input, std::vector<T>& output, Pred& pred) {
+    output.resize(input.size());
+    std::size_t count = 0;
+    std::size_t i = 0;
+#if CARL_HAS_SIMD
+    for (; i + width<T> <= input.size(); i += width<T>) {
+        const Vector<T> chunk(input.data() + i, stdx::element_aligned);
+        const auto mask = pred(chunk);
+        if (stdx::none_of(mask)) {
+            continue;
+        }
+        if (stdx::all_of(mask)) {
+            chunk.copy_to(output.data() + count, stdx::element_aligned);
+            count += width<T>;
+            continue;
+        }
+        for (std::size_t lane = 0; lane < width<T>; ++lane) {
+            output[count] = chunk[lane];
+            count += mask[lane] ? 1 : 0;
+        }
+    }
+#endif
+    for (; i < input.size(); ++i) {
+        output[count] = input[i];
+        count += pred(input[i]) ? 1 : 0;
+    }
+    output.resize(count);
+}
+
+// Tree reduction: lanes accumulate independently across the batch and are
+// combined pairwise at the end (`horizontal`), which also breaks the serial
+// dependency chain of a scalar fold.
+template <SimdElement T, typename Op, typename LaneOp, typename Horizontal>
+T reduce(std::span<const T> input, T identity, Op op, [[maybe_unused]] LaneOp lane_op,
+         [[maybe_unused]] Horizontal horizontal) {
+    T result = identity;
+    std::size_t i = 0;
+#if CARL_HAS_SIMD
+    if (input.size() >= width<T>) {
+        Vector<T> lanes(identity);
+        for (; i + width<T> <= input.size(); i += width<T>) {
+            lanes = lane_op(lanes, Vector<T>(input.data() + i, stdx::element_aligned));
+        }
+        result = horizontal(lanes);
+    }
+#endif
+    for (; i < input.size(); ++i) {
+        result = op(result, input[i]);
+    }
+    return result;
+}
+
+#if CARL_HAS_SIMD
+template <SimdElement T>
+T sum(std::span<const T> input) {
+    return reduce(
+        input, T{0}, std::plus<>{}, std::plus<>{}, [](const Vector<T>& lanes) { return stdx::reduce(lanes); });
+}
+
+template <SimdElement T>
+T min(std::span<const T> input, T identity) {
+    return reduce(
+        input, identity, [](T a, T b) { return std::min(a, b); },
+        [](const Vector<T>& a, const Vector<T>& b) { return stdx::min(a, b); },
+        [](const Vector<T>& lanes) { return stdx::hmin(lanes); });
+}
+
+template <SimdElement T>
+T max(std::span<const T> input, T identity) {
+    return reduce(
+        input, identity, [](T a, T b) { return std::max(a, b); },
+        [](const Vector<T>& a, const Vector<T>& b) { return stdx::max(a, b); },
+        [](const Vector<T>& lanes) { return stdx::hmax(lanes); });
+}
+#else
+template <SimdElement T>
+T sum(std::span<const T> input) {
+    return reduce(input, T{0}, std::plus<>{}, nullptr, nullptr);
+}
+
+template <SimdElement T>
+T min(std::span<const T> input, T identity) {
+    return reduce(input, identity, [](T a, T b) { return std::min(a, b); }, nullptr, nullptr);
+}
+
+template <SimdElement T>
+T max(std::span<const T> input, T identity) {
+    return reduce(input, identity, [](T a, T b) { return std::max(a, b); }, nullptr, nullptr);
+}
+#endif
+
+}  // namespace simd
+}  // namespace carl
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "carl/job.h"
+#include "carl/mpsc_queue.h"
+#include "carl/scheduler.h"
+
+namespace carl {
+
+// Serial executor on top of a Scheduler. Work posted to one strand runs one
+// item at a time in posting order, while different strands run in parallel.
+// Reactive nodes dispatch through a strand so that consecutive events on a
+// node are delivered in order even on a multi-worker scheduler.
+//
+// Posting is lock-free: jobs go into an intrusive MPSC queue and only the
+// post that finds the strand idle schedules the runner. The runner drains up
+// to batch_size jobs per turn and then yields its worker. Strands must be
+// owned by a shared_ptr; a scheduled runner keeps its strand alive.
+class Strand : public std::enable_shared_from_this<Strand> {
+public:
+    static constexpr std::size_t batch_size = 64;
+
+    explicit Strand(Scheduler& scheduler) : scheduler_(scheduler), runner_(this) {}
+
+    Strand(const Strand&) = delete;
+    Strand& operator=(const Strand&) = delete;
+
+    Scheduler& scheduler() const noexcept {
+        return scheduler_;
+    }
+
+    template <typename Fn>
+    void post(Fn&& fn) {
+        queue_.push(make_job(std::forward<Fn>(fn)));
+        if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            runner_.self = shared_from_this();
+            scheduler_.schedule(&runner_);
+        }
+    }
+
+private:
+    struct Runner : Job {
+        explicit Runner(Strand* owner) : Job(&Runner::execute), strand(owner) {}
+
+        static void execute(Job* job) {
+            static_cast<Runner*>(job)->strand->drain();
+        }
+
+        Strand* strand;
+        std::shared_ptr<Strand> self{};
+    };
+
+    void drain() {
+        auto self = std::move(runner_.self);
+        for (std::size_t i = 0; i < batch_size; ++i) {
+            Job* job = nullptr;
+            // A producer that has bumped pending_ may not have linked its
+            // node yet; it is about to.
+            while ((job = queue_.pop()) == nullptr) {
+                std::this_thread::yield();
+            }
+            job->run();
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                return;
+            }
+        }
+        runner_.self = std::move(self);
+        scheduler_.schedule(&runner_);
+    }
+
+    Scheduler& scheduler_;
+    Runner runner_;
+    IntrusiveMpscQueue<Job> queue_{};
+    alignas(64) std::atomic<std::size_t> pending_{0};
+};
+
+// A reactive node's strand, created on the node's first scheduled dispatch
+// and bound to that scheduler from then on.
+class NodeStrand {
+public:
+    Strand& get(Scheduler& scheduler) {
+        std::call_once(once_, [this, &scheduler]() { strand_ = std::make_shared<Strand>(scheduler); });
+        return *strand_;
+    }
+
+private:
+    std::once_flag once_{};
+    std::shared_ptr<Strand> strand_{};
+};
+
+}  // namespace carl
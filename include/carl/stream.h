@@ -1,16 +1,24 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <span>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "carl/metrics.h"
+#include "carl/observer_list.h"
+#include "carl/payload.h"
 #include "carl/scheduler.h"
 #include "carl/signal.h"
+#include "carl/strand.h"
 #include "carl/subscription.h"
-#include "carl/task.h"
+#include "carl/trace.h"
 
 namespace carl {
 
@@ -18,45 +26,73 @@ template <typename T>
 class Stream {
 public:
     using Callback = std::function<void(const T&)>;
+    using BatchCallback = std::function<void(std::span<const T>)>;
 
     Stream() : state_(std::make_shared<State>()), ownership_(std::make_shared<Ownership>()) {}
 
     void emit(T value) {
-        std::vector<Callback> callbacks;
-        {
-            std::lock_guard<std::mutex> lock(state_->mutex);
-            callbacks = state_->observers;
-        }
-
-        for (const auto& callback : callbacks) {
-            if (callback) {
-                callback(value);
-            }
-        }
+        trace::Scope scope("stream.emit");
+        state_->metrics.emits.add();
+        metrics::ScopedTimer timer(state_->metrics.callback_time);
+        dispatch_callbacks(*state_->observers.snapshot(), value);
+        BatchObservers::notify(*state_->batch_observers.snapshot(), std::span<const T>(&value, 1));
     }
 
     void emit(Scheduler& scheduler, T value) {
-        std::vector<Callback> callbacks;
-        {
-            std::lock_guard<std::mutex> lock(state_->mutex);
-            callbacks = state_->observers;
+        state_->metrics.emits.add();
+        state_->strand.get(scheduler).post([callbacks = state_->observers.snapshot(),
+                          batch_callbacks = state_->batch_observers.snapshot(), node = metrics::node_ref(state_),
+                          hop = trace::Hop("stream.emit"), payload = std::move(value)]() {
+            trace::Scope scope("stream.dispatch", hop);
+            metrics::ScopedTimer timer(metrics::callback_histogram(node));
+            dispatch_callbacks(*callbacks, payload);
+            BatchObservers::notify(*batch_callbacks, std::span<const T>(&payload, 1));
+        });
+    }
+
+    // Emits a contiguous chunk of events. Batch observers (the built-in
+    // operators) receive the whole chunk in one call; per-event observers
+    // are called for each element in order.
+    void emit_batch(std::span<const T> values) {
+        if (values.empty()) {
+            return;
         }
+        state_->metrics.emits.add(values.size());
+        dispatch_batch(*state_, values);
+    }
 
-        scheduler.spawn(dispatch_callbacks(std::move(callbacks), std::move(value)));
+    void emit_batch(Scheduler& scheduler, std::vector<T> values) {
+        if (values.empty()) {
+            return;
+        }
+        state_->metrics.emits.add(values.size());
+        state_->strand.get(scheduler).post(
+            [state = state_, hop = trace::Hop("stream.emit_batch"), payload = std::move(values)]() {
+                trace::Scope scope("stream.dispatch", hop);
+                dispatch_batch(*state, std::span<const T>(payload));
+            });
     }
 
     Subscription subscribe(Callback callback) {
-        std::lock_guard<std::mutex> lock(state_->mutex);
-        const std::size_t index = state_->observers.size();
-        state_->observers.emplace_back(std::move(callback));
+        const auto handle = state_->observers.add(std::move(callback));
 
         std::weak_ptr<State> weak_state = state_;
-        return Subscription([weak_state, index]() {
+        return Subscription([weak_state, handle]() {
             if (auto shared_state = weak_state.lock()) {
-                std::lock_guard<std::mutex> guard(shared_state->mutex);
-                if (index < shared_state->observers.size()) {
-                    shared_state->observers[index] = nullptr;
-                }
+                shared_state->observers.remove(handle);
+            }
+        });
+    }
+
+    // Subscribes to events a chunk at a time; a single emit() arrives as a
+    // one-element span.
+    Subscription subscribe_batch(BatchCallback callback) {
+        const auto handle = state_->batch_observers.add(std::move(callback));
+
+        std::weak_ptr<State> weak_state = state_;
+        return Subscription([weak_state, handle]() {
+            if (auto shared_state = weak_state.lock()) {
+                shared_state->batch_observers.remove(handle);
             }
         });
     }
@@ -66,19 +102,54 @@ public:
         ownership_->subscriptions.emplace_back(std::move(subscription));
     }
 
+    const void* id() const noexcept {
+        return state_.get();
+    }
+
+    // Reads the node's live stats without keeping it alive; empty once the
+    // node is gone. Emit counts and callback times need CARL_ENABLE_METRICS.
+    std::function<std::optional<metrics::NodeStats>()> probe() const {
+        return [weak = std::weak_ptr<State>(state_)]() -> std::optional<metrics::NodeStats> {
+            const auto state = weak.lock();
+            if (!state) {
+                return std::nullopt;
+            }
+            return metrics::NodeStats{"stream", reinterpret_cast<std::uintptr_t>(state.get()),
+                                      state->metrics.emits.load(),
+                                      state->observers.size() + state->batch_observers.size(),
+                                      state->metrics.callback_time.snapshot()};
+        };
+    }
+
 private:
-    static Task dispatch_callbacks(std::vector<Callback> callbacks, T value) {
-        for (const auto& callback : callbacks) {
-            if (callback) {
-                callback(value);
+    using Observers = ObserverList<Callback>;
+
+    using BatchObservers = ObserverList<BatchCallback>;
+
+    static void dispatch_callbacks(const typename Observers::Snapshot& callbacks, const T& value) {
+        Observers::notify(callbacks, value);
+    }
+
+    struct State;
+
+    static void dispatch_batch(State& state, std::span<const T> values) {
+        metrics::ScopedTimer timer(state.metrics.callback_time);
+        const auto callbacks = state.observers.snapshot();
+        if (!callbacks->empty()) {
+            for (const T& value : values) {
+                dispatch_callbacks(*callbacks, value);
             }
         }
-        co_return;
+        BatchObservers::notify(*state.batch_observers.snapshot(), values);
     }
 
+    // Scheduled dispatches go through the node's strand, so observers see
+    // this stream's events in emission order.
     struct State {
-        std::mutex mutex;
-        std::vector<Callback> observers;
+        Observers observers;
+        BatchObservers batch_observers;
+        NodeStrand strand;
+        metrics::NodeMetrics metrics{"stream", [this]() { return observers.size() + batch_observers.size(); }};
     };
 
     struct Ownership {
@@ -90,16 +161,67 @@ private:
     std::shared_ptr<Ownership> ownership_{};
 };
 
+// The map/filter/fold operators subscribe a chunk at a time and run one tight
+// loop over each chunk, so per-node dispatch is paid once per batch. Single
+// events skip the intermediate buffer entirely.
+template <typename T, typename Fn>
+auto map_batch(std::span<const T> values, Fn& fn) {
+    using Result = std::invoke_result_t<Fn&, const T&>;
+    std::vector<Result> results;
+    if constexpr (std::is_default_constructible_v<Result>) {
+        results.resize(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            results[i] = fn(values[i]);
+        }
+    } else {
+        results.reserve(values.size());
+        for (const T& value : values) {
+            results.push_back(fn(value));
+        }
+    }
+    return results;
+}
+
+// Arithmetic elements are compacted without a branch: every element is
+// written and only kept ones advance the cursor. Anything else is copied
+// only when it passes.
+template <typename T, typename Pred>
+std::vector<T> filter_batch(std::span<const T> values, Pred& pred) {
+    std::vector<T> kept;
+    if constexpr (std::is_arithmetic_v<T>) {
+        kept.resize(values.size());
+        std::size_t count = 0;
+        for (const T& value : values) {
+            kept[count] = value;
+            count += pred(value) ? 1 : 0;
+        }
+        kept.resize(count);
+    } else {
+        kept.reserve(values.size());
+        for (const T& value : values) {
+            if (pred(value)) {
+                kept.push_back(value);
+            }
+        }
+    }
+    return kept;
+}
+
 template <typename T, typename Fn>
 auto stream_map(Stream<T>& input, Fn&& fn) {
     using Result = std::invoke_result_t<Fn, const T&>;
     Stream<Result> output;
 
-    auto forward = [output, func = std::forward<Fn>(fn)](const T& value) mutable {
-        output.emit(func(value));
+    auto forward = [output, func = std::forward<Fn>(fn)](std::span<const T> values) mutable {
+        if (values.size() == 1) {
+            output.emit(func(values.front()));
+        } else {
+            const auto results = map_batch(values, func);
+            output.emit_batch(results);
+        }
     };
 
-    output.keep_alive(input.subscribe(std::move(forward)));
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
     return output;
 }
 
@@ -108,11 +230,15 @@ auto stream_map(Scheduler& scheduler, Stream<T>& input, Fn&& fn) {
     using Result = std::invoke_result_t<Fn, const T&>;
     Stream<Result> output;
 
-    auto forward = [output, &scheduler, func = std::forward<Fn>(fn)](const T& value) mutable {
-        output.emit(scheduler, func(value));
+    auto forward = [output, &scheduler, func = std::forward<Fn>(fn)](std::span<const T> values) mutable {
+        if (values.size() == 1) {
+            output.emit(scheduler, func(values.front()));
+        } else {
+            output.emit_batch(scheduler, map_batch(values, func));
+        }
     };
 
-    output.keep_alive(input.subscribe(std::move(forward)));
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
     return output;
 }
 
@@ -120,13 +246,18 @@ template <typename T, typename Pred>
 auto stream_filter(Stream<T>& input, Pred&& pred) {
     Stream<T> output;
 
-    auto forward = [output, predicate = std::forward<Pred>(pred)](const T& value) mutable {
-        if (predicate(value)) {
-            output.emit(value);
+    auto forward = [output, predicate = std::forward<Pred>(pred)](std::span<const T> values) mutable {
+        if (values.size() == 1) {
+            if (predicate(values.front())) {
+                output.emit(values.front());
+            }
+        } else {
+            const auto kept = filter_batch(values, predicate);
+            output.emit_batch(kept);
         }
     };
 
-    output.keep_alive(input.subscribe(std::move(forward)));
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
     return output;
 }
 
@@ -134,34 +265,287 @@ template <typename T, typename Pred>
 auto stream_filter(Scheduler& scheduler, Stream<T>& input, Pred&& pred) {
     Stream<T> output;
 
-    auto forward = [output, &scheduler, predicate = std::forward<Pred>(pred)](const T& value) mutable {
-        if (predicate(value)) {
-            output.emit(scheduler, value);
+    auto forward = [output, &scheduler, predicate = std::forward<Pred>(pred)](std::span<const T> values) mutable {
+        if (values.size() == 1) {
+            if (predicate(values.front())) {
+                output.emit(scheduler, values.front());
+            }
+        } else {
+            output.emit_batch(scheduler, filter_batch(values, predicate));
         }
     };
 
-    output.keep_alive(input.subscribe(std::move(forward)));
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
     return output;
 }
 
+// Wraps each event once in a Payload. Observers, scheduled dispatches and
+// actor mailboxes downstream then share that copy, which pays off in front
+// of a wide fan-out of large values.
+template <typename T>
+Stream<Payload<T>> stream_share(Stream<T>& input) {
+    return stream_map(input, [](const T& value) { return Payload<T>(value); });
+}
+
+template <typename T>
+Stream<Payload<T>> stream_share(Scheduler& scheduler, Stream<T>& input) {
+    return stream_map(scheduler, input, [](const T& value) { return Payload<T>(value); });
+}
+
+// The accumulator is private to the fold and updated under its own lock, so
+// concurrent emitters cannot lose updates. A chunk is folded in one pass.
+// The output is set outside the lock, so an observer may emit back into the
+// input; one caller at a time publishes, and it keeps setting the newest
+// accumulator until every fold is published, so sets stay in order.
+template <typename Acc, typename Fn>
+struct FoldState {
+    FoldState(Acc seed, Fn fn) : accumulator(std::move(seed)), func(std::move(fn)) {}
+
+    // Returns true when the caller must publish().
+    template <typename T>
+    bool fold(std::span<const T> values) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const T& value : values) {
+            accumulator = func(std::move(accumulator), value);
+        }
+        ++folded;
+        if (publishing) {
+            return false;
+        }
+        publishing = true;
+        return true;
+    }
+
+    template <typename Set>
+    void publish(Set&& set) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (published != folded) {
+            published = folded;
+            Acc value = accumulator;
+            lock.unlock();
+            set(std::move(value));
+            lock.lock();
+        }
+        publishing = false;
+    }
+
+    std::mutex mutex{};
+    Acc accumulator;
+    Fn func;
+    std::uint64_t folded{0};
+    std::uint64_t published{0};
+    bool publishing{false};
+};
+
 template <typename T, typename Acc, typename Fn>
 auto stream_fold(Stream<T>& input, Acc seed, Fn&& fn) {
     Signal<Acc> output(seed);
+    auto state = std::make_shared<FoldState<Acc, std::decay_t<Fn>>>(std::move(seed), std::forward<Fn>(fn));
 
-    auto forward = [output, func = std::forward<Fn>(fn)](const T& value) mutable {
-        output.set(func(output.value(), value));
+    auto forward = [output, state](std::span<const T> values) mutable {
+        if (state->fold(values)) {
+            state->publish([&output](Acc value) { output.set(std::move(value)); });
+        }
     };
 
-    output.keep_alive(input.subscribe(std::move(forward)));
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
     return output;
 }
 
 template <typename T, typename Acc, typename Fn>
 auto stream_fold(Scheduler& scheduler, Stream<T>& input, Acc seed, Fn&& fn) {
     Signal<Acc> output(seed);
+    auto state = std::make_shared<FoldState<Acc, std::decay_t<Fn>>>(std::move(seed), std::forward<Fn>(fn));
+
+    auto forward = [output, &scheduler, state](std::span<const T> values) mutable {
+        if (state->fold(values)) {
+            state->publish([&output, &scheduler](Acc value) { output.set(scheduler, std::move(value)); });
+        }
+    };
+
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
+    return output;
+}
+
+// Time-based operators. Each keeps at most one timer armed, and only while
+// it has something to emit, so idle operators cost nothing and a burst of
+// events schedules a single timer.
+
+// Emits the latest value once `quiet` has passed without a new event.
+template <typename T, typename Rep, typename Period>
+Stream<T> stream_debounce(Scheduler& scheduler, Stream<T>& input, std::chrono::duration<Rep, Period> quiet) {
+    struct State : std::enable_shared_from_this<State> {
+        State(Scheduler& owner, Stream<T> out, Scheduler::Clock::duration delay)
+            : scheduler(owner), output(std::move(out)), quiet(delay) {}
+
+        void arm(Scheduler::Clock::time_point deadline) {
+            scheduler.submit_at(deadline, [self = this->shared_from_this()]() { self->fire(); });
+        }
+
+        void fire() {
+            std::optional<T> value;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                const auto deadline = last_event + quiet;
+                if (Scheduler::Clock::now() < deadline) {
+                    arm(deadline);
+                    return;
+                }
+                value.swap(latest);
+                armed = false;
+            }
+            output.emit(std::move(*value));
+        }
+
+        Scheduler& scheduler;
+        Stream<T> output;
+        const Scheduler::Clock::duration quiet;
+        std::mutex mutex{};
+        std::optional<T> latest{};
+        Scheduler::Clock::time_point last_event{};
+        bool armed{false};
+    };
+
+    Stream<T> output;
+    auto state = std::make_shared<State>(scheduler, output, std::chrono::ceil<Scheduler::Clock::duration>(quiet));
+
+    auto forward = [state](const T& value) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->latest = value;
+        state->last_event = Scheduler::Clock::now();
+        if (!std::exchange(state->armed, true)) {
+            state->arm(state->last_event + state->quiet);
+        }
+    };
+
+    output.keep_alive(input.subscribe(std::move(forward)));
+    return output;
+}
+
+// Emits at most one value per `interval`: the first event of a burst right
+// away, then the latest one when the interval closes.
+template <typename T, typename Rep, typename Period>
+Stream<T> stream_throttle(Scheduler& scheduler, Stream<T>& input, std::chrono::duration<Rep, Period> interval) {
+    struct State : std::enable_shared_from_this<State> {
+        State(Scheduler& owner, Stream<T> out, Scheduler::Clock::duration period)
+            : scheduler(owner), output(std::move(out)), interval(period) {}
+
+        void fire() {
+            std::optional<T> value;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                armed = false;
+                if (!pending) {
+                    return;
+                }
+                value.swap(pending);
+                last_emit = Scheduler::Clock::now();
+            }
+            output.emit(std::move(*value));
+        }
+
+        Scheduler& scheduler;
+        Stream<T> output;
+        const Scheduler::Clock::duration interval;
+        std::mutex mutex{};
+        std::optional<T> pending{};
+        std::optional<Scheduler::Clock::time_point> last_emit{};
+        bool armed{false};
+    };
+
+    Stream<T> output;
+    auto state = std::make_shared<State>(scheduler, output, std::chrono::ceil<Scheduler::Clock::duration>(interval));
 
-    auto forward = [output, &scheduler, func = std::forward<Fn>(fn)](const T& value) mutable {
-        output.set(scheduler, func(output.value(), value));
+    auto forward = [state](const T& value) {
+        const auto now = Scheduler::Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->armed || (state->last_emit && now < *state->last_emit + state->interval)) {
+                state->pending = value;
+                if (!std::exchange(state->armed, true)) {
+                    state->scheduler.submit_at(*state->last_emit + state->interval,
+                                               [self = state->shared_from_this()]() { self->fire(); });
+                }
+                return;
+            }
+            state->last_emit = now;
+        }
+        state->output.emit(value);
+    };
+
+    output.keep_alive(input.subscribe(std::move(forward)));
+    return output;
+}
+
+// Emits the most recent value once per `period`, starting one period after
+// the first new value; nothing is emitted while the input is quiet.
+template <typename T, typename Rep, typename Period>
+Stream<T> stream_sample(Scheduler& scheduler, Stream<T>& input, std::chrono::duration<Rep, Period> period) {
+    struct State {
+        explicit State(Stream<T> out) : output(std::move(out)) {}
+
+        Stream<T> output;
+        std::mutex mutex{};
+        std::optional<T> latest{};
+        bool armed{false};
+    };
+
+    Stream<T> output;
+    auto state = std::make_shared<State>(output);
+    const auto delay = std::chrono::ceil<Scheduler::Clock::duration>(period);
+
+    auto forward = [state, &scheduler, delay](const T& value) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->latest = value;
+        if (std::exchange(state->armed, true)) {
+            return;
+        }
+        scheduler.submit_after(delay, [state]() {
+            std::optional<T> sample;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                sample.swap(state->latest);
+                state->armed = false;
+            }
+            state->output.emit(std::move(*sample));
+        });
+    };
+
+    output.keep_alive(input.subscribe(std::move(forward)));
+    return output;
+}
+
+// Collects events into windows of `window`, opened by the first event, and
+// emits each window as one batch.
+template <typename T, typename Rep, typename Period>
+Stream<std::vector<T>> stream_buffer_time(Scheduler& scheduler, Stream<T>& input,
+                                          std::chrono::duration<Rep, Period> window) {
+    struct State {
+        explicit State(Stream<std::vector<T>> out) : output(std::move(out)) {}
+
+        Stream<std::vector<T>> output;
+        std::mutex mutex{};
+        std::vector<T> buffer{};
+    };
+
+    Stream<std::vector<T>> output;
+    auto state = std::make_shared<State>(output);
+    const auto delay = std::chrono::ceil<Scheduler::Clock::duration>(window);
+
+    auto forward = [state, &scheduler, delay](const T& value) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->buffer.push_back(value);
+        if (state->buffer.size() != 1) {
+            return;
+        }
+        scheduler.submit_after(delay, [state]() {
+            std::vector<T> batch;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                batch.swap(state->buffer);
+            }
+            state->output.emit(std::move(batch));
+        });
     };
 
     output.keep_alive(input.subscribe(std::move(forward)));
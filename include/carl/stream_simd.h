@@ -0,0 +1,171 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "carl/scheduler.h"
+#include "carl/signal.h"
+#include "carl/simd.h"
+#include "carl/stream.h"
+
+namespace carl {
+
+// Opt-in data-parallel counterparts of stream_map/stream_filter/stream_fold
+// for arithmetic element types. Batches go through the carl::simd kernels;
+// single events take the scalar path. `fn` and `pred` must accept both a
+// simd vector and a scalar, e.g. [](auto x) { return x * 2.0; }.
+template <SimdElement T, typename Fn>
+Stream<T> stream_map_simd(Stream<T>& input, Fn&& fn) {
+    Stream<T> output;
+
+    auto forward = [output, func = std::forward<Fn>(fn)](std::span<const T> values) mutable {
+        if (values.size() == 1) {
+            output.emit(static_cast<T>(func(values.front())));
+            return;
+        }
+        std::vector<T> results(values.size());
+        simd::transform(values, std::span<T>(results), func);
+        output.emit_batch(results);
+    };
+
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
+    return output;
+}
+
+template <SimdElement T, typename Fn>
+Stream<T> stream_map_simd(Scheduler& scheduler, Stream<T>& input, Fn&& fn) {
+    Stream<T> output;
+
+    auto forward = [output, &scheduler, func = std::forward<Fn>(fn)](std::span<const T> values) mutable {
+        if (values.size() == 1) {
+            output.emit(scheduler, static_cast<T>(func(values.front())));
+            return;
+        }
+        std::vector<T> results(values.size());
+        simd::transform(values, std::span<T>(results), func);
+        output.emit_batch(scheduler, std::move(results));
+    };
+
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
+    return output;
+}
+
+template <SimdElement T, typename Pred>
+Stream<T> stream_filter_simd(Stream<T>& input, Pred&& pred) {
+    Stream<T> output;
+
+    auto forward = [output, predicate = std::forward<Pred>(pred)](std::span<const T> values) mutable {
+        if (values.size() == 1) {
+            if (predicate(values.front())) {
+                output.emit(values.front());
+            }
+            return;
+        }
+        std::vector<T> kept;
+        simd::compress(values, kept, predicate);
+        output.emit_batch(kept);
+    };
+
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
+    return output;
+}
+
+template <SimdElement T, typename Pred>
+Stream<T> stream_filter_simd(Scheduler& scheduler, Stream<T>& input, Pred&& pred) {
+    Stream<T> output;
+
+    auto forward = [output, &scheduler, predicate = std::forward<Pred>(pred)](std::span<const T> values) mutable {
+        if (values.size() == 1) {
+            if (predicate(values.front())) {
+                output.emit(scheduler, values.front());
+            }
+            return;
+        }
+        std::vector<T> kept;
+        simd::compress(values, kept, predicate);
+        output.emit_batch(scheduler, std::move(kept));
+    };
+
+    output.keep_alive(input.subscribe_batch(std::move(forward)));
+    return output;
+}
+
+// Running sum/min/max folds. Each batch is reduced with a tree reduction and
+// combined with a private running value, so the signal is set once per batch
+// and concurrent emitters cannot lose updates.
+template <SimdElement T, typename Reduce>
+Signal<T> stream_reduce_simd(Stream<T>& input, T seed, Reduce reduce) {
+    struct State {
+        explicit State(T initial) : value(initial) {}
+
+        std::mutex mutex{};
+        T value;
+    };
+
+    Signal<T> output(seed);
+    auto state = std::make_shared<State>(seed);
+    output.keep_alive(input.subscribe_batch([output, state, reduce](std::span<const T> values) mutable {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->value = reduce(values, state->value);
+        output.set(state->value);
+    }));
+    return output;
+}
+
+template <SimdElement T, typename Reduce>
+Signal<T> stream_reduce_simd(Scheduler& scheduler, Stream<T>& input, T seed, Reduce reduce) {
+    struct State {
+        explicit State(T initial) : value(initial) {}
+
+        std::mutex mutex{};
+        T value;
+    };
+
+    Signal<T> output(seed);
+    auto state = std::make_shared<State>(seed);
+    output.keep_alive(input.subscribe_batch([output, &scheduler, state, reduce](std::span<const T> values) mutable {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->value = reduce(values, state->value);
+        output.set(scheduler, state->value);
+    }));
+    return output;
+}
+
+template <SimdElement T>
+Signal<T> stream_sum(Stream<T>& input, T seed = T{0}) {
+    return stream_reduce_simd(input, seed, [](std::span<const T> values, T total) { return total + simd::sum(values); });
+}
+
+template <SimdElement T>
+Signal<T> stream_min(Stream<T>& input, T seed = std::numeric_limits<T>::max()) {
+    return stream_reduce_simd(input, seed, [](std::span<const T> values, T low) { return simd::min(values, low); });
+}
+
+template <SimdElement T>
+Signal<T> stream_max(Stream<T>& input, T seed = std::numeric_limits<T>::lowest()) {
+    return stream_reduce_simd(input, seed, [](std::span<const T> values, T high) { return simd::max(values, high); });
+}
+
+template <SimdElement T>
+Signal<T> stream_sum(Scheduler& scheduler, Stream<T>& input, T seed = T{0}) {
+    return stream_reduce_simd(scheduler, input, seed,
+                              [](std::span<const T> values, T total) { return total + simd::sum(values); });
+}
+
+template <SimdElement T>
+Signal<T> stream_min(Scheduler& scheduler, Stream<T>& input, T seed = std::numeric_limits<T>::max()) {
+    return stream_reduce_simd(scheduler, input, seed,
+                              [](std::span<const T> values, T low) { return simd::min(values, low); });
+}
+
+template <SimdElement T>
+Signal<T> stream_max(Scheduler& scheduler, Stream<T>& input, T seed = std::numeric_limits<T>::lowest()) {
+    return stream_reduce_simd(scheduler, input, seed,
+                              [](std::span<const T> values, T high) { return simd::max(values, high); });
+}
+
+}  // namespace carl
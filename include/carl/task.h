@@ -3,6 +3,8 @@
 #include <coroutine>
 #include <utility>
 
+#include "carl/memory_pool.h"
+
 namespace carl {
 
 class Task {
@@ -41,7 +43,25 @@ public:
         return std::exchange(handle_, {});
     }
 
-    struct promise_type {
+    struct FinalAwaitable {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(handle_type handle) const noexcept {
+            if (handle.promise().detached) {
+                handle.destroy();
+            }
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // Coroutine frames are drawn from the per-thread MemoryPool, so spawning
+    // a short-lived task does not hit the global allocator.
+    struct promise_type : PoolAllocated {
+        bool detached{false};
+
         Task get_return_object() {
             return Task(handle_type::from_promise(*this));
         }
@@ -50,7 +70,7 @@ public:
             return {};
         }
 
-        std::suspend_always final_suspend() noexcept {
+        FinalAwaitable final_suspend() noexcept {
             return {};
         }
 
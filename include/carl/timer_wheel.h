@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace carl {
+
+struct TimerNode {
+    TimerNode* next_timer{nullptr};
+    std::uint64_t deadline{0};
+};
+
+// Hierarchical hashed timer wheel over integer ticks. Level L has 64 slots
+// of 64^L ticks each; a timer lives on the level of the highest 6-bit digit
+// in which its deadline differs from the current tick, and cascades to a
+// lower level when the wheel reaches its slot. Insertion is O(1), and
+// advance() jumps straight to the next occupied slot using per-level
+// occupancy bitmaps, so idle stretches cost nothing. Not thread-safe.
+class TimerWheel {
+public:
+    static constexpr std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+    // Expired timers (deadline at or before the current tick) are appended to
+    // the due list and handed back by the next advance().
+    void insert(TimerNode* node) {
+        if (node->deadline <= current_) {
+            node->next_timer = due_;
+            due_ = node;
+            return;
+        }
+        const std::size_t level = level_for(node->deadline);
+        const std::size_t slot = slot_for(node->deadline, level);
+        node->next_timer = slots_[level][slot];
+        slots_[level][slot] = node;
+        occupied_[level] |= std::uint64_t{1} << slot;
+    }
+
+    // Moves the wheel to `now` and returns the expired timers as a list
+    // linked through next_timer.
+    TimerNode* advance(std::uint64_t now) {
+        TimerNode* expired = std::exchange(due_, nullptr);
+        while (true) {
+            std::size_t level = 0;
+            std::size_t slot = 0;
+            const std::uint64_t start = next_slot(level, slot);
+            if (start == never || start > now) {
+                break;
+            }
+            current_ = start;
+            TimerNode* node = slots_[level][slot];
+            slots_[level][slot] = nullptr;
+            occupied_[level] &= ~(std::uint64_t{1} << slot);
+            while (node != nullptr) {
+                TimerNode* next = node->next_timer;
+                if (node->deadline <= current_) {
+                    node->next_timer = expired;
+                    expired = node;
+                } else {
+                    insert(node);
+                }
+                node = next;
+            }
+        }
+        if (now > current_) {
+            current_ = now;
+        }
+        return expired;
+    }
+
+    // Earliest tick at which advance() can return a timer; never if empty.
+    std::uint64_t next_expiration() const {
+        if (due_ != nullptr) {
+            return current_;
+        }
+        std::size_t level = 0;
+        std::size_t slot = 0;
+        return next_slot(level, slot);
+    }
+
+    // Unlinks every pending timer and returns them as one list.
+    TimerNode* clear() {
+        TimerNode* all = std::exchange(due_, nullptr);
+        for (std::size_t level = 0; level < levels; ++level) {
+            for (auto& head : slots_[level]) {
+                while (head != nullptr) {
+                    TimerNode* next = head->next_timer;
+                    head->next_timer = all;
+                    all = head;
+                    head = next;
+                }
+            }
+            occupied_[level] = 0;
+        }
+        return all;
+    }
+
+private:
+    static constexpr std::size_t slot_bits = 6;
+    static constexpr std::size_t slots = std::size_t{1} << slot_bits;
+    static constexpr std::size_t levels = (64 + slot_bits - 1) / slot_bits;
+
+    std::size_t level_for(std::uint64_t deadline) const {
+        const std::uint64_t diff = deadline ^ current_;
+        return (63 - static_cast<std::size_t>(std::countl_zero(diff))) / slot_bits;
+    }
+
+    static std::size_t slot_for(std::uint64_t deadline, std::size_t level) {
+        return static_cast<std::size_t>(deadline >> (level * slot_bits)) & (slots - 1);
+    }
+
+    // Start tick of the earliest occupied slot across all levels.
+    std::uint64_t next_slot(std::size_t& out_level, std::size_t& out_slot) const {
+        std::uint64_t best = never;
+        for (std::size_t level = 0; level < levels; ++level) {
+            if (occupied_[level] == 0) {
+                continue;
+            }
+            const std::size_t shift = level * slot_bits;
+            const std::size_t position = slot_for(current_, level);
+            const std::uint64_t pending = occupied_[level] & (~std::uint64_t{0} << position);
+            if (pending == 0) {
+                continue;
+            }
+            const std::size_t slot = static_cast<std::size_t>(std::countr_zero(pending));
+            const std::size_t span_bits = shift + slot_bits;
+            const std::uint64_t base = span_bits >= 64 ? 0 : current_ & ~((std::uint64_t{1} << span_bits) - 1);
+            const std::uint64_t start = base + (static_cast<std::uint64_t>(slot) << shift);
+            if (start < best) {
+                best = start;
+                out_level = level;
+                out_slot = slot;
+            }
+        }
+        return best;
+    }
+
+    std::uint64_t current_{0};
+    TimerNode* due_{nullptr};
+    std::array<std::array<TimerNode*, slots>, levels> slots_{};
+    std::array<std::uint64_t, levels> occupied_{};
+};
+
+}  // namespace carl
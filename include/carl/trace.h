@@ -0,0 +1,279 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Event tracing in the Chrome trace event format, which chrome://tracing
+// and ui.perfetto.dev both load. Define CARL_ENABLE_TRACING=1 (CMake:
+// -DCARL_TRACING=ON) to compile it in; otherwise Hop and Scope are empty
+// types and every call below is a no-op.
+#ifndef CARL_ENABLE_TRACING
+#define CARL_ENABLE_TRACING 0
+#endif
+
+namespace carl::trace {
+
+inline constexpr bool enabled = CARL_ENABLE_TRACING != 0;
+
+#if CARL_ENABLE_TRACING
+
+struct Event {
+    std::uint64_t ts_ns{0};
+    std::uint64_t id{0};
+    const char* name{nullptr};
+    char phase{0};
+};
+
+// Single-writer ring of the most recent events of one thread. The owner
+// writes a slot and then publishes it by bumping head; a full ring
+// overwrites its oldest events.
+class ThreadBuffer {
+public:
+    static constexpr std::size_t capacity = std::size_t{1} << 16;
+
+    explicit ThreadBuffer(std::uint32_t thread_id) : tid(thread_id) {}
+
+    void record(char phase, const char* name, std::uint64_t id, std::uint64_t ts_ns) {
+        const std::uint64_t head = head_.load(std::memory_order_relaxed);
+        events_[head & (capacity - 1)] = Event{ts_ns, id, name, phase};
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        const std::uint64_t first = head > capacity ? head - capacity : 0;
+        for (std::uint64_t i = first; i < head; ++i) {
+            fn(events_[i & (capacity - 1)]);
+        }
+    }
+
+    void clear() {
+        head_.store(0, std::memory_order_release);
+    }
+
+    std::uint64_t next_id() noexcept {
+        return (static_cast<std::uint64_t>(tid) << 40) | ++ids_;
+    }
+
+    const std::uint32_t tid;
+
+private:
+    std::array<Event, capacity> events_{};
+    std::atomic<std::uint64_t> head_{0};
+    std::uint64_t ids_{0};
+};
+
+// Owns every thread's buffer, so events survive their threads until they
+// are written out. Recording is off until start().
+class Tracer {
+public:
+    static Tracer& global() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void start() {
+        recording_.store(true, std::memory_order_relaxed);
+    }
+
+    void stop() {
+        recording_.store(false, std::memory_order_relaxed);
+    }
+
+    bool recording() const noexcept {
+        return recording_.load(std::memory_order_relaxed);
+    }
+
+    // Registration takes the lock once per thread; recording never does.
+    ThreadBuffer& buffer() {
+        thread_local ThreadBuffer* local = nullptr;
+        if (local == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.push_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(buffers_.size() + 1)));
+            local = buffers_.back().get();
+        }
+        return *local;
+    }
+
+    std::uint64_t now_ns() const {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count());
+    }
+
+    // Call while no thread is recording (stop() and let the scheduler go
+    // quiet); the buffers are read without synchronizing with writers.
+    std::string to_chrome_json() const {
+        std::ostringstream out;
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& buffer : buffers_) {
+            buffer->for_each([&](const Event& event) {
+                out << (first ? "\n" : ",\n");
+                first = false;
+                write_event(out, buffer->tid, event);
+            });
+        }
+        out << "\n]}\n";
+        return out.str();
+    }
+
+    bool write_chrome_json(const std::string& path) const {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file << to_chrome_json();
+        return static_cast<bool>(file);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& buffer : buffers_) {
+            buffer->clear();
+        }
+    }
+
+private:
+    static void write_event(std::ostream& out, std::uint32_t tid, const Event& event) {
+        out << "{\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << event.ts_ns / 1000
+            << '.' << (event.ts_ns % 1000) / 100 << (event.ts_ns % 100) / 10 << event.ts_ns % 10;
+        if (event.phase == 's' || event.phase == 'f') {
+            out << ",\"name\":\"flow\",\"cat\":\"carl\",\"id\":" << event.id;
+            if (event.phase == 'f') {
+                out << ",\"bp\":\"e\"";
+            }
+        } else {
+            out << ",\"name\":\"" << event.name << "\",\"cat\":\"carl\"";
+            if (event.phase == 'X') {
+                out << ",\"dur\":0";
+            }
+        }
+        out << '}';
+    }
+
+    mutable std::mutex mutex_{};
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_{};
+    std::atomic<bool> recording_{false};
+    const std::chrono::steady_clock::time_point epoch_{std::chrono::steady_clock::now()};
+};
+
+// One causal hop: recorded where work is handed off (a post or scheduled
+// dispatch) and closed by the Scope that runs it, so the viewer draws an
+// arrow from sender to receiver. Hops sent from inside a Scope start at
+// that slice, which chains them into the event's full path.
+class Hop {
+public:
+    Hop() = default;
+
+    explicit Hop(const char* name) {
+        Tracer& tracer = Tracer::global();
+        if (!tracer.recording()) {
+            return;
+        }
+        ThreadBuffer& buffer = tracer.buffer();
+        const std::uint64_t ts = tracer.now_ns();
+        id_ = buffer.next_id();
+        buffer.record('X', name, 0, ts);
+        buffer.record('s', name, id_, ts);
+    }
+
+    std::uint64_t id() const noexcept {
+        return id_;
+    }
+
+private:
+    std::uint64_t id_{0};
+};
+
+// A slice on the current thread's track, from construction to destruction.
+class Scope {
+public:
+    explicit Scope(const char* name, const Hop& hop = Hop{}) : name_(name) {
+        Tracer& tracer = Tracer::global();
+        if (!tracer.recording()) {
+            name_ = nullptr;
+            return;
+        }
+        buffer_ = &tracer.buffer();
+        const std::uint64_t ts = tracer.now_ns();
+        buffer_->record('B', name_, 0, ts);
+        if (hop.id() != 0) {
+            buffer_->record('f', name_, hop.id(), ts);
+        }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    ~Scope() {
+        if (name_ != nullptr) {
+            buffer_->record('E', name_, 0, Tracer::global().now_ns());
+        }
+    }
+
+private:
+    const char* name_;
+    ThreadBuffer* buffer_{nullptr};
+};
+
+#else
+
+class Tracer {
+public:
+    static Tracer& global() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void start() {}
+    void stop() {}
+
+    bool recording() const noexcept {
+        return false;
+    }
+
+    std::string to_chrome_json() const {
+        return "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[]}\n";
+    }
+
+    bool write_chrome_json(const std::string& path) const {
+        std::ofstream file(path, std::ios::trunc);
+        file << to_chrome_json();
+        return static_cast<bool>(file);
+    }
+
+    void clear() {}
+};
+
+class Hop {
+public:
+    Hop() = default;
+    explicit Hop(const char*) noexcept {}
+
+    std::uint64_t id() const noexcept {
+        return 0;
+    }
+};
+
+class Scope {
+public:
+    explicit Scope(const char*, const Hop& = Hop{}) noexcept {}
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+#endif
+
+}  // namespace carl::trace
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "carl/payload.h"
+#include "carl/scheduler.h"
+
+namespace carl {
+
+// Trivially copyable values up to a cache line are copied out of a seqlock;
+// anything else is published as an immutable Payload.
+template <typename T>
+inline constexpr bool stores_inline =
+    std::is_trivially_copyable_v<T> && std::default_initializable<T> && sizeof(T) <= 64;
+
+// A single-writer value that readers load without a lock. Each store()
+// bumps version(), so a reader can tell whether anything was published
+// since it last looked. Stores must be serialized by the caller; each one
+// returns the snapshot it published.
+template <typename T, bool Inline = stores_inline<T>>
+class VersionedValue;
+
+// Seqlock over the value's bytes, held in relaxed atomic words. The
+// sequence is odd while a store is in progress; a load that overlaps one
+// retries, so readers never block the writer or each other.
+template <typename T>
+class VersionedValue<T, true> {
+public:
+    using Snapshot = T;
+
+    explicit VersionedValue(const T& initial) noexcept {
+        write_words(initial);
+    }
+
+    T load() const noexcept {
+        std::array<std::uint64_t, word_count> words;
+        for (;;) {
+            const std::uint64_t before = sequence_.load(std::memory_order_acquire);
+            if ((before & 1) != 0) {
+                cpu_relax();
+                continue;
+            }
+            for (std::size_t i = 0; i < word_count; ++i) {
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+    T store(const T& value) noexcept {
+        const std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        write_words(value);
+        sequence_.store(sequence + 2, std::memory_order_release);
+        return value;
+    }
+
+    std::uint64_t version() const noexcept {
+        return sequence_.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    static constexpr std::size_t word_count = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    void write_words(const T& value) noexcept {
+        std::array<std::uint64_t, word_count> words{};
+        std::memcpy(words.data(), static_cast<const void*>(&value), sizeof(T));
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<std::uint64_t> sequence_{0};
+    std::array<std::atomic<std::uint64_t>, word_count> words_{};
+};
+
+// Atomic shared_ptr snapshot. A load shares the published value; a store
+// swaps in a new one and old readers keep theirs.
+template <typename T>
+class VersionedValue<T, false> {
+public:
+    using Snapshot = Payload<T>;
+
+    explicit VersionedValue(T initial) : value_(std::make_shared<const T>(std::move(initial))) {}
+
+    Payload<T> load() const noexcept {
+        return Payload<T>(value_.load(std::memory_order_acquire));
+    }
+
+    Payload<T> store(T value) {
+        auto published = std::make_shared<const T>(std::move(value));
+        value_.store(published, std::memory_order_release);
+        // After the value, so a reader that sees a version loads a value at
+        // least that recent.
+        version_.fetch_add(1, std::memory_order_release);
+        return Payload<T>(std::move(published));
+    }
+
+    std::uint64_t version() const noexcept {
+        return version_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<std::shared_ptr<const T>> value_;
+    std::atomic<std::uint64_t> version_{0};
+};
+
+}  // namespace carl
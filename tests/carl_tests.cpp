@@ -1,10 +1,57 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "carl/actor.h"
+#include "carl/affinity.h"
+#include "carl/channel.h"
+#include "carl/graph_registry.h"
+#include "carl/mailbox.h"
+#include "carl/metrics.h"
+#include "carl/metrics_export.h"
+#include "carl/observer_list.h"
+#include "carl/payload.h"
+#include "carl/pipeline.h"
+#include "carl/propagation_engine.h"
 #include "carl/reactive_context.h"
 #include "carl/scheduler.h"
 #include "carl/signal.h"
+#include "carl/simd.h"
+#include "carl/strand.h"
 #include "carl/stream.h"
+#include "carl/stream_simd.h"
+#include "carl/timer_wheel.h"
+#include "carl/trace.h"
+
+std::atomic<std::size_t> allocation_count{0};
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
 
 namespace {
 
@@ -26,6 +73,26 @@ public:
     explicit TestActor(carl::Scheduler& scheduler) : carl::Actor(scheduler) {}
 };
 
+carl::Task increment(std::atomic<int>& counter) {
+    counter.fetch_add(1);
+    co_return;
+}
+
+carl::Task fan_out(carl::Scheduler& scheduler, std::atomic<int>& counter, int count) {
+    for (int i = 0; i < count; ++i) {
+        scheduler.spawn(increment(counter));
+    }
+    co_await scheduler.yield();
+    counter.fetch_add(1);
+}
+
+carl::Task sleep_then_record(carl::Scheduler& scheduler, std::atomic<long long>& elapsed_ms) {
+    const auto start = std::chrono::steady_clock::now();
+    co_await scheduler.sleep_for(std::chrono::milliseconds(20));
+    elapsed_ms.store(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
 void test_signal_map() {
     carl::Scheduler scheduler(1);
     carl::ReactiveContext context(scheduler);
@@ -65,6 +132,22 @@ void test_stream_fold() {
     stream.emit(scheduler, 3);
     scheduler.run();
     EXPECT_EQ(sum.value(), 6);
+
+    // An observer of the fold may emit back into its input.
+    carl::Stream<int> input;
+    auto total = carl::stream_fold(input, 0, [](int acc, int value) { return acc + value; });
+    std::vector<int> seen;
+    auto sub = total.subscribe([&input, &seen](const int& value) {
+        seen.push_back(value);
+        if (value == 1) {
+            input.emit(10);
+        }
+    });
+    input.emit(1);
+    EXPECT_EQ(total.value(), 11);
+    EXPECT_EQ(seen.size(), std::size_t{2});
+    EXPECT_EQ(seen.front(), 1);
+    EXPECT_EQ(seen.back(), 11);
 }
 
 void test_multi_node_chain() {
@@ -110,6 +193,1210 @@ void test_actor_message_loop() {
     EXPECT_EQ(signal.value(), 42);
 }
 
+void test_actor_stop_runs_on_stop() {
+    class StoppingActor : public carl::Actor {
+    public:
+        explicit StoppingActor(carl::Scheduler& scheduler) : carl::Actor(scheduler) {}
+
+        std::atomic<bool> stopped{false};
+
+    protected:
+        void on_stop() override {
+            stopped.store(true);
+        }
+    };
+
+    for (int i = 0; i < 100; ++i) {
+        carl::Scheduler scheduler(2);
+        StoppingActor actor(scheduler);
+        scheduler.spawn(actor.run());
+        actor.post([&actor]() { actor.stop(); });
+        scheduler.run();
+        EXPECT_EQ(actor.stopped.load(), true);
+    }
+}
+
+void test_actor_parks_when_idle() {
+    carl::Scheduler scheduler(2);
+    TestActor actor(scheduler);
+    std::atomic<int> handled{0};
+
+    scheduler.spawn(actor.run());
+    scheduler.run();
+    EXPECT_EQ(scheduler.empty(), true);
+
+    for (int i = 0; i < 100; ++i) {
+        actor.post([&handled]() { handled.fetch_add(1); });
+    }
+    scheduler.run();
+    EXPECT_EQ(handled.load(), 100);
+
+    actor.post([&actor]() { actor.stop(); });
+    scheduler.run();
+}
+
+void test_actor_park_wake_cycles() {
+    carl::Scheduler scheduler(2);
+    TestActor actor(scheduler);
+    std::atomic<int> handled{0};
+
+    scheduler.spawn(actor.run());
+    {
+        std::jthread producer([&actor, &handled]() {
+            for (int i = 0; i < 2000; ++i) {
+                actor.post([&handled]() { handled.fetch_add(1); });
+                if (i % 4 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    while (handled.load() < 2000) {
+        scheduler.run();
+    }
+    EXPECT_EQ(handled.load(), 2000);
+
+    actor.post([&actor]() { actor.stop(); });
+    scheduler.run();
+}
+
+void test_mailbox_drain() {
+    carl::Mailbox<int> mailbox;
+    std::vector<std::jthread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&mailbox, p]() {
+            for (int i = 0; i < 1000; ++i) {
+                (void)mailbox.push(p * 1000 + i);
+            }
+        });
+    }
+    producers.clear();
+
+    long long sum = 0;
+    std::size_t batches = 0;
+    while (!mailbox.empty()) {
+        const std::size_t handled = mailbox.drain(16, [&sum](int value) { sum += value; });
+        EXPECT_EQ(handled <= 16, true);
+        ++batches;
+    }
+    EXPECT_EQ(sum, 3999LL * 4000 / 2);
+    EXPECT_EQ(batches, std::size_t{250});
+}
+
+void test_actor_batch_contention() {
+    carl::Scheduler scheduler(4);
+    carl::Actor actor(scheduler, 8);
+    int handled = 0;
+
+    scheduler.spawn(actor.run());
+    std::vector<std::jthread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&actor, &handled]() {
+            for (int i = 0; i < 2500; ++i) {
+                actor.post([&handled]() { ++handled; });
+            }
+        });
+    }
+    producers.clear();
+    scheduler.run();
+    EXPECT_EQ(handled, 10000);
+
+    actor.post([&actor]() { actor.stop(); });
+    scheduler.run();
+}
+
+void test_inline_function() {
+    using Function = carl::InlineFunction<int(int), 32>;
+    auto owned = std::make_unique<int>(5);
+    Function small = [owned = std::move(owned)](int value) { return *owned + value; };
+    Function moved = std::move(small);
+    EXPECT_EQ(static_cast<bool>(small), false);
+    EXPECT_EQ(moved(2), 7);
+
+    struct Large {
+        long long values[8];
+    };
+    EXPECT_EQ(Function::stores_inline<Large>, false);
+    Large large{{1, 2, 3, 4, 5, 6, 7, 8}};
+    Function boxed = [large](int value) { return static_cast<int>(large.values[7]) + value; };
+    EXPECT_EQ(boxed(1), 9);
+}
+
+void test_actor_messages_allocation_free() {
+    struct Tick {
+        double fields[8];
+    };
+
+    carl::Scheduler scheduler(1);
+    TestActor actor(scheduler);
+    double total = 0.0;
+    scheduler.spawn(actor.run());
+
+    auto deliver = [&]() {
+        for (int i = 0; i < 1000; ++i) {
+            Tick tick{{1.0}};
+            actor.post([&total, tick]() { total += tick.fields[0]; });
+        }
+        scheduler.run();
+    };
+
+    deliver();
+    const std::size_t before = allocation_count.load();
+    deliver();
+    const std::size_t allocations = allocation_count.load() - before;
+
+    EXPECT_EQ(total, 2000.0);
+    EXPECT_EQ(allocations < 10, true);
+
+    actor.post([&actor]() { actor.stop(); });
+    scheduler.run();
+}
+
+void test_pooled_frames_and_jobs() {
+    carl::Scheduler scheduler(1);
+    std::atomic<int> counter{0};
+
+    scheduler.spawn(fan_out(scheduler, counter, 1000));
+    scheduler.run();
+    const std::size_t before = allocation_count.load();
+    scheduler.spawn(fan_out(scheduler, counter, 1000));
+    scheduler.run();
+    const std::size_t allocations = allocation_count.load() - before;
+
+    EXPECT_EQ(counter.load(), 2 * 1001);
+    EXPECT_EQ(allocations < 10, true);
+
+    for (int i = 0; i < 100; ++i) {
+        scheduler.submit([&counter]() { counter.fetch_add(1); });
+    }
+    scheduler.run();
+    EXPECT_EQ(counter.load(), 2 * 1001 + 100);
+}
+
+void test_emit_uses_observer_snapshot() {
+    carl::Stream<int> stream;
+    int received = 0;
+    std::vector<carl::Subscription> subscriptions;
+    for (int i = 0; i < 50; ++i) {
+        subscriptions.push_back(stream.subscribe([&received](const int& value) { received += value; }));
+    }
+
+    const std::size_t before = allocation_count.load();
+    for (int i = 0; i < 100; ++i) {
+        stream.emit(1);
+    }
+    EXPECT_EQ(allocation_count.load() - before, std::size_t{0});
+    EXPECT_EQ(received, 5000);
+
+    subscriptions[10].unsubscribe();
+    stream.emit(1);
+    EXPECT_EQ(received, 5049);
+}
+
+void test_subscription_churn_compacts() {
+    using Observers = carl::ObserverList<std::function<void(const int&)>>;
+    Observers observers;
+    int received = 0;
+    auto keep = observers.add([&received](const int& value) { received += value; });
+
+    for (int i = 0; i < 100000; ++i) {
+        auto handle = observers.add([&received](const int& value) { received -= value; });
+        observers.remove(handle);
+    }
+    EXPECT_EQ(observers.size(), std::size_t{1});
+    EXPECT_EQ(observers.snapshot()->size() <= Observers::min_compaction_threshold + 1, true);
+
+    auto stale = observers.add([](const int&) {});
+    observers.remove(stale);
+    auto fresh = observers.add([&received](const int& value) { received += 10 * value; });
+    observers.remove(stale);
+    Observers::notify(*observers.snapshot(), 1);
+    EXPECT_EQ(received, 11);
+    observers.remove(fresh);
+    observers.remove(keep);
+    EXPECT_EQ(observers.size(), std::size_t{0});
+}
+
+void test_actor_subscription_allocation_free() {
+    struct Tick {
+        double fields[8];
+    };
+
+    carl::Scheduler scheduler(1);
+    TestActor actor(scheduler);
+    carl::Stream<Tick> ticks;
+    double total = 0.0;
+    auto sub = actor.subscribe(ticks, [&total](const Tick& tick) { total += tick.fields[0]; });
+    scheduler.spawn(actor.run());
+
+    auto deliver = [&]() {
+        for (int i = 0; i < 1000; ++i) {
+            ticks.emit(Tick{{1.0}});
+        }
+        scheduler.run();
+    };
+
+    deliver();
+    const std::size_t before = allocation_count.load();
+    deliver();
+    const std::size_t allocations = allocation_count.load() - before;
+
+    EXPECT_EQ(total, 2000.0);
+    EXPECT_EQ(allocations < 10, true);
+
+    actor.post([&actor]() { actor.stop(); });
+    scheduler.run();
+}
+
+void test_glitch_free_diamond() {
+    carl::Scheduler scheduler(4);
+    carl::ReactiveContext context(scheduler);
+    carl::PropagationEngine engine(scheduler);
+
+    carl::Signal<int> base(1);
+    auto plus_one = context.signal_map(base, [](int value) { return value + 1; });
+    auto doubled = context.signal_map(base, [](int value) { return value * 2; });
+    std::atomic<int> recomputes{0};
+    auto sum = context.signal_combine(plus_one, doubled, [&recomputes](int a, int b) {
+        recomputes.fetch_add(1);
+        return a + b;
+    });
+    std::atomic<int> glitches{0};
+    std::atomic<int> notifications{0};
+    auto sub = sum.subscribe([&glitches, &notifications](const int& value) {
+        notifications.fetch_add(1);
+        if ((value - 1) % 3 != 0) {
+            glitches.fetch_add(1);
+        }
+    });
+
+    EXPECT_EQ(base.rank(), std::size_t{0});
+    EXPECT_EQ(sum.rank(), std::size_t{2});
+
+    recomputes.store(0);
+    for (int i = 2; i <= 100; ++i) {
+        engine.set(base, i);
+    }
+    scheduler.run();
+
+    EXPECT_EQ(sum.value(), 301);
+    EXPECT_EQ(recomputes.load(), 99);
+    EXPECT_EQ(notifications.load(), 99);
+    EXPECT_EQ(glitches.load(), 0);
+}
+
+void test_transaction_batches_updates() {
+    carl::Scheduler scheduler(4);
+    carl::ReactiveContext context(scheduler);
+
+    carl::Signal<int> bid(0);
+    carl::Signal<int> ask(0);
+    std::atomic<int> recomputes{0};
+    auto spread = context.signal_combine(bid, ask, [&recomputes](int b, int a) {
+        recomputes.fetch_add(1);
+        return a - b;
+    });
+    std::atomic<int> inconsistent{0};
+    std::atomic<int> notifications{0};
+    auto sub = spread.subscribe([&inconsistent, &notifications](const int& value) {
+        notifications.fetch_add(1);
+        if (value % 2 != 0) {
+            inconsistent.fetch_add(1);
+        }
+    });
+
+    recomputes.store(0);
+    for (int i = 1; i <= 50; ++i) {
+        context.transaction([&]() {
+            bid.set(i);
+            ask.set(3 * i);
+        });
+    }
+    context.transaction([&]() {
+        bid.set(99);
+        context.transaction([&]() { ask.set(297); });
+    });
+    scheduler.run();
+
+    EXPECT_EQ(spread.value(), 198);
+    EXPECT_EQ(bid.value(), 99);
+    EXPECT_EQ(recomputes.load(), 51);
+    EXPECT_EQ(notifications.load(), 51);
+    EXPECT_EQ(inconsistent.load(), 0);
+}
+
+void test_signal_change_suppression() {
+    carl::Signal<double> sensor(20.0);
+    std::atomic<int> clamp_runs{0};
+    auto clamped = carl::signal_map(sensor, [&clamp_runs](double value) {
+        clamp_runs.fetch_add(1);
+        return value > 25.0 ? 25.0 : value;
+    });
+    std::atomic<int> downstream{0};
+    auto label = carl::signal_map(clamped, [&downstream](double value) {
+        downstream.fetch_add(1);
+        return value >= 25.0 ? 1 : 0;
+    });
+
+    clamp_runs.store(0);
+    downstream.store(0);
+    for (double reading : {30.0, 31.0, 29.5, 40.0, 30.0}) {
+        sensor.set(reading);
+    }
+    sensor.set(30.0);
+    EXPECT_EQ(clamp_runs.load(), 5);
+    EXPECT_EQ(downstream.load(), 1);
+    EXPECT_EQ(label.value(), 1);
+
+    std::atomic<int> smoothed_runs{0};
+    auto smoothed = carl::signal_map_distinct(
+        sensor, [](double value) { return value; }, carl::approx_equal(0.5));
+    auto smoothed_sub = smoothed.subscribe([&smoothed_runs](const double&) { smoothed_runs.fetch_add(1); });
+    sensor.set(30.2);
+    sensor.set(30.4);
+    sensor.set(31.0);
+    EXPECT_EQ(smoothed_runs.load(), 1);
+    EXPECT_EQ(smoothed.value(), 31.0);
+
+    carl::Signal<int> ticks(0, carl::always_notify);
+    std::atomic<int> tick_notifications{0};
+    auto tick_sub = ticks.subscribe([&tick_notifications](const int&) { tick_notifications.fetch_add(1); });
+    ticks.set(0);
+    ticks.set(0);
+    EXPECT_EQ(tick_notifications.load(), 2);
+}
+
+void test_lazy_signal_nodes() {
+    carl::Signal<int> price(1);
+    std::atomic<int> scaled_runs{0};
+    std::atomic<int> label_runs{0};
+    auto scaled = carl::signal_map_lazy(price, [&scaled_runs](int value) {
+        scaled_runs.fetch_add(1);
+        return value * 10;
+    });
+    auto label = carl::signal_map_lazy(scaled, [&label_runs](int value) {
+        label_runs.fetch_add(1);
+        return value + 1;
+    });
+    carl::Signal<int> quantity(2);
+    auto notional = carl::signal_combine_lazy(price, quantity, [](int p, int q) { return p * q; });
+
+    scaled_runs.store(0);
+    label_runs.store(0);
+    for (int i = 2; i <= 1000; ++i) {
+        price.set(i);
+    }
+    EXPECT_EQ(scaled_runs.load(), 0);
+    EXPECT_EQ(label_runs.load(), 0);
+    EXPECT_EQ(label.dirty(), true);
+
+    EXPECT_EQ(label.value(), 10001);
+    EXPECT_EQ(label.value(), 10001);
+    EXPECT_EQ(scaled_runs.load(), 1);
+    EXPECT_EQ(label_runs.load(), 1);
+    EXPECT_EQ(notional.value(), 2000);
+
+    std::atomic<int> observed{0};
+    auto sub = scaled.subscribe([&observed](const int& value) { observed.store(value); });
+    price.set(7);
+    EXPECT_EQ(observed.load(), 70);
+    EXPECT_EQ(scaled_runs.load(), 2);
+    EXPECT_EQ(label_runs.load(), 1);
+    EXPECT_EQ(label.value(), 71);
+}
+
+void test_bounded_subscriptions() {
+    auto deliver = [](carl::OverflowPolicy policy) {
+        carl::Scheduler scheduler(2);
+        carl::Actor actor(scheduler);
+        carl::Stream<int> events;
+        std::vector<int> seen;
+        auto sub = actor.subscribe(events, carl::Backpressure{4, policy},
+                                   [&seen](int value) { seen.push_back(value); });
+        for (int i = 0; i < 10; ++i) {
+            events.emit(i);
+        }
+        EXPECT_EQ(sub.buffered(), policy == carl::OverflowPolicy::conflate ? std::size_t{1} : std::size_t{4});
+
+        scheduler.spawn(actor.run());
+        scheduler.run();
+        actor.post([&actor]() { actor.stop(); });
+        scheduler.run();
+        return std::make_pair(seen, sub.dropped());
+    };
+
+    auto [newest, newest_dropped] = deliver(carl::OverflowPolicy::drop_newest);
+    EXPECT_EQ(newest == std::vector<int>({0, 1, 2, 3}), true);
+    EXPECT_EQ(newest_dropped, std::uint64_t{6});
+
+    auto [oldest, oldest_dropped] = deliver(carl::OverflowPolicy::drop_oldest);
+    EXPECT_EQ(oldest == std::vector<int>({6, 7, 8, 9}), true);
+    EXPECT_EQ(oldest_dropped, std::uint64_t{6});
+
+    auto [latest, conflated] = deliver(carl::OverflowPolicy::conflate);
+    EXPECT_EQ(latest == std::vector<int>({9}), true);
+    EXPECT_EQ(conflated, std::uint64_t{9});
+
+    carl::Scheduler scheduler(2);
+    carl::Actor actor(scheduler);
+    carl::Stream<int> events;
+    std::vector<int> seen;
+    auto sub = actor.subscribe(events, carl::Backpressure{2, carl::OverflowPolicy::block},
+                               [&seen](int value) { seen.push_back(value); });
+    scheduler.spawn(actor.run());
+    for (int i = 0; i < 1000; ++i) {
+        events.emit(i);
+        EXPECT_EQ(sub.buffered() <= 2, true);
+    }
+    scheduler.run();
+    EXPECT_EQ(static_cast<int>(seen.size()), 1000);
+    EXPECT_EQ(seen.back(), 999);
+    EXPECT_EQ(sub.dropped(), std::uint64_t{0});
+
+    // The default policy drops instead of blocking, and slots need no default
+    // constructor.
+    struct Reading {
+        explicit Reading(int raw) : value(raw) {}
+        int value;
+    };
+    EXPECT_EQ(carl::Backpressure{}.policy == carl::OverflowPolicy::drop_oldest, true);
+    carl::Stream<Reading> readings;
+    std::atomic<int> last{0};
+    auto reading_sub = actor.subscribe(readings, carl::Backpressure{.capacity = 2},
+                                       [&last](const Reading& reading) { last.store(reading.value); });
+    for (int i = 1; i <= 5; ++i) {
+        readings.emit(Reading(i));
+    }
+    scheduler.run();
+    EXPECT_EQ(last.load(), 5);
+
+    actor.post([&actor]() { actor.stop(); });
+    scheduler.run();
+}
+
+void test_timer_wheel() {
+    std::vector<carl::TimerNode> nodes(8);
+    const std::uint64_t deadlines[] = {1, 63, 64, 65, 4095, 4096, 5000, 300000};
+    carl::TimerWheel wheel;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i].deadline = deadlines[i];
+        wheel.insert(&nodes[i]);
+    }
+
+    int fired = 0;
+    bool off_schedule = false;
+    std::uint64_t now = 0;
+    while (fired < 8 && now < 400000) {
+        now += 7;
+        for (auto* node = wheel.advance(now); node != nullptr; node = node->next_timer) {
+            off_schedule = off_schedule || node->deadline > now || node->deadline + 7 <= now;
+            ++fired;
+        }
+    }
+    EXPECT_EQ(fired, 8);
+    EXPECT_EQ(off_schedule, false);
+    EXPECT_EQ(wheel.next_expiration(), carl::TimerWheel::never);
+
+    carl::TimerNode late;
+    late.deadline = 10;
+    wheel.insert(&late);
+    EXPECT_EQ(wheel.advance(now) == &late, true);
+}
+
+void test_time_operators() {
+    using namespace std::chrono_literals;
+    carl::Scheduler scheduler(2);
+
+    std::atomic<long long> slept_ms{0};
+    scheduler.spawn(sleep_then_record(scheduler, slept_ms));
+    scheduler.run();
+    EXPECT_EQ(slept_ms.load() >= 20, true);
+
+    carl::Stream<int> input;
+    auto debounced = carl::stream_debounce(scheduler, input, 50ms);
+    auto throttled = carl::stream_throttle(scheduler, input, 50ms);
+    auto sampled = carl::stream_sample(scheduler, input, 30ms);
+    auto windows = carl::stream_buffer_time(scheduler, input, 30ms);
+
+    std::mutex mutex;
+    std::vector<int> debounce_seen;
+    std::vector<int> throttle_seen;
+    std::vector<int> sample_seen;
+    std::vector<std::size_t> window_sizes;
+    auto debounce_sub = debounced.subscribe([&](const int& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        debounce_seen.push_back(value);
+    });
+    auto throttle_sub = throttled.subscribe([&](const int& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        throttle_seen.push_back(value);
+    });
+    auto sample_sub = sampled.subscribe([&](const int& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sample_seen.push_back(value);
+    });
+    auto window_sub = windows.subscribe([&](const std::vector<int>& batch) {
+        std::lock_guard<std::mutex> lock(mutex);
+        window_sizes.push_back(batch.size());
+    });
+
+    for (int i = 0; i < 10000; ++i) {
+        input.emit(i);
+    }
+    scheduler.run();
+
+    // How the burst splits into intervals depends on how fast this machine
+    // emits, so only check what holds for any timing: values come out in
+    // order, the last one always gets through, and throttle lets the first
+    // one through right away.
+    const auto increasing = [](const std::vector<int>& values) {
+        return std::adjacent_find(values.begin(), values.end(), std::greater_equal<int>()) == values.end();
+    };
+    EXPECT_EQ(debounce_seen.empty() ? -1 : debounce_seen.back(), 9999);
+    EXPECT_EQ(increasing(debounce_seen), true);
+    EXPECT_EQ(throttle_seen.empty() ? -1 : throttle_seen.front(), 0);
+    EXPECT_EQ(throttle_seen.empty() ? -1 : throttle_seen.back(), 9999);
+    EXPECT_EQ(increasing(throttle_seen), true);
+    EXPECT_EQ(sample_seen.empty() ? -1 : sample_seen.back(), 9999);
+    EXPECT_EQ(increasing(sample_seen), true);
+    std::size_t windowed = 0;
+    for (std::size_t size : window_sizes) {
+        windowed += size;
+    }
+    EXPECT_EQ(windowed, std::size_t{10000});
+
+    // Events further apart than the interval each pass the throttle.
+    carl::Stream<int> spaced;
+    auto spaced_throttled = carl::stream_throttle(scheduler, spaced, 20ms);
+    std::vector<int> spaced_seen;
+    auto spaced_sub = spaced_throttled.subscribe([&](const int& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        spaced_seen.push_back(value);
+    });
+    for (int i = 0; i < 3; ++i) {
+        spaced.emit(i);
+        std::this_thread::sleep_for(40ms);
+    }
+    scheduler.run();
+    EXPECT_EQ(spaced_seen == std::vector<int>({0, 1, 2}), true);
+
+    // The time operators hold pending values in optionals, so T need not be
+    // default-constructible.
+    struct Reading {
+        explicit Reading(int raw) : value(raw) {}
+        int value;
+    };
+    carl::Stream<Reading> readings;
+    auto quiet = carl::stream_debounce(scheduler, readings, 5ms);
+    auto paced = carl::stream_throttle(scheduler, readings, 5ms);
+    auto ticks = carl::stream_sample(scheduler, readings, 5ms);
+    std::atomic<int> last_quiet{0};
+    std::atomic<int> last_paced{0};
+    std::atomic<int> last_tick{0};
+    auto quiet_sub = quiet.subscribe([&](const Reading& reading) { last_quiet.store(reading.value); });
+    auto paced_sub = paced.subscribe([&](const Reading& reading) { last_paced.store(reading.value); });
+    auto tick_sub = ticks.subscribe([&](const Reading& reading) { last_tick.store(reading.value); });
+    readings.emit(Reading(1));
+    readings.emit(Reading(2));
+    scheduler.run();
+    EXPECT_EQ(last_quiet.load(), 2);
+    EXPECT_EQ(last_paced.load(), 2);
+    EXPECT_EQ(last_tick.load(), 2);
+}
+
+void test_stream_emit_batch() {
+    carl::Stream<int> ticks;
+    auto doubled = carl::stream_map(ticks, [](int value) { return value * 2; });
+    auto large = carl::stream_filter(doubled, [](int value) { return value >= 4096; });
+    auto total = carl::stream_fold(large, 0LL, [](long long sum, int value) { return sum + value; });
+
+    int batches = 0;
+    std::size_t batched_events = 0;
+    auto batch_sub = large.subscribe_batch([&](std::span<const int> values) {
+        ++batches;
+        batched_events += values.size();
+    });
+    int events = 0;
+    auto event_sub = doubled.subscribe([&events](const int&) { ++events; });
+
+    std::vector<int> chunk(4096);
+    for (int i = 0; i < 4096; ++i) {
+        chunk[i] = i;
+    }
+    ticks.emit_batch(chunk);
+
+    EXPECT_EQ(batches, 1);
+    EXPECT_EQ(batched_events, std::size_t{2048});
+    EXPECT_EQ(events, 4096);
+    EXPECT_EQ(total.value(), 2LL * (2048LL + 4095LL) * 2048LL / 2LL);
+
+    ticks.emit(5000);
+    EXPECT_EQ(batches, 2);
+    EXPECT_EQ(total.value(), 2LL * (2048LL + 4095LL) * 2048LL / 2LL + 10000LL);
+
+    carl::Scheduler scheduler(2);
+    carl::Stream<int> async_ticks;
+    auto async_doubled = carl::stream_map(scheduler, async_ticks, [](int value) { return value * 2; });
+    auto async_total = carl::stream_fold(scheduler, async_doubled, 0LL, [](long long sum, int value) { return sum + value; });
+    async_ticks.emit_batch(scheduler, chunk);
+    scheduler.run();
+    EXPECT_EQ(async_total.value(), 4096LL * 4095LL);
+
+    // Element types without a default constructor filter a batch too.
+    struct Reading {
+        explicit Reading(int raw) : value(raw) {}
+        int value;
+    };
+    carl::Stream<Reading> readings;
+    auto odd = carl::stream_filter(readings, [](const Reading& reading) { return reading.value % 2 != 0; });
+    auto large_readings =
+        carl::stream_filter(scheduler, readings, [](const Reading& reading) { return reading.value > 2; });
+    int odd_sum = 0;
+    std::atomic<int> async_count{0};
+    auto odd_sub = odd.subscribe([&odd_sum](const Reading& reading) { odd_sum += reading.value; });
+    auto large_sub = large_readings.subscribe([&async_count](const Reading&) { async_count.fetch_add(1); });
+    const std::vector<Reading> batch{Reading(1), Reading(2), Reading(3), Reading(4)};
+    readings.emit_batch(batch);
+    scheduler.run();
+    EXPECT_EQ(odd_sum, 4);
+    EXPECT_EQ(async_count.load(), 2);
+}
+
+void test_simd_stream_operators() {
+    for (std::size_t size = 0; size < 40; ++size) {
+        std::vector<std::int64_t> values(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            values[i] = static_cast<std::int64_t>((i * 37) % 23) - 11;
+        }
+        std::int64_t sum = 0;
+        std::int64_t low = 100;
+        std::vector<std::int64_t> positive;
+        for (auto value : values) {
+            sum += value;
+            low = std::min(low, value);
+            if (value > 0) {
+                positive.push_back(value);
+            }
+        }
+        auto above_zero = [](auto x) { return x > 0; };
+        std::vector<std::int64_t> kept;
+        carl::simd::compress(std::span<const std::int64_t>(values), kept, above_zero);
+        EXPECT_EQ(carl::simd::sum(std::span<const std::int64_t>(values)), sum);
+        EXPECT_EQ(carl::simd::min(std::span<const std::int64_t>(values), std::int64_t{100}), low);
+        EXPECT_EQ(kept == positive, true);
+    }
+
+    carl::Stream<double> celsius;
+    auto fahrenheit = carl::stream_map_simd(celsius, [](auto c) { return c * 9.0 / 5.0 + 32.0; });
+    auto hot = carl::stream_filter_simd(fahrenheit, [](auto f) { return f > 100.0; });
+    auto hottest = carl::stream_max(hot);
+    auto total = carl::stream_sum(fahrenheit);
+    std::size_t hot_count = 0;
+    auto hot_sub = hot.subscribe([&hot_count](const double&) { ++hot_count; });
+
+    std::vector<double> readings(1001);
+    for (std::size_t i = 0; i < readings.size(); ++i) {
+        readings[i] = static_cast<double>(i) / 10.0;
+    }
+    celsius.emit_batch(readings);
+    celsius.emit(50.0);
+
+    EXPECT_EQ(hot_count, std::size_t{624});
+    EXPECT_EQ(hottest.value(), 212.0);
+    EXPECT_EQ(total.value() > 122243.9 && total.value() < 122244.1, true);
+
+    // Through a ReactiveContext the folds publish on the scheduler, like
+    // every other context operator.
+    carl::Scheduler scheduler(2);
+    carl::ReactiveContext context(scheduler);
+    carl::Stream<std::int64_t> counts;
+    auto count_sum = context.stream_sum(counts);
+    auto count_min = context.stream_min(counts);
+    auto count_max = context.stream_max(counts);
+    std::atomic<int> notified{0};
+    auto sum_sub = count_sum.subscribe([&notified](const std::int64_t&) { notified.fetch_add(1); });
+    const std::vector<std::int64_t> batch{4, -2, 9, 1};
+    counts.emit_batch(batch);
+    scheduler.run();
+    EXPECT_EQ(notified.load(), 1);
+    EXPECT_EQ(count_sum.value(), std::int64_t{12});
+    EXPECT_EQ(count_min.value(), std::int64_t{-2});
+    EXPECT_EQ(count_max.value(), std::int64_t{9});
+}
+
+void test_fused_pipeline() {
+    carl::Stream<int> source;
+    auto labels = source | carl::filter([](int value) { return value % 2 == 0; })
+                  | carl::map([](int value) { return value * 3; })
+                  | carl::map([](int value) { return static_cast<double>(value) / 2.0; }) | carl::to_stream();
+
+    std::vector<double> seen;
+    auto sub = labels.subscribe([&seen](const double& value) { seen.push_back(value); });
+    seen.reserve(16);
+
+    long long total = 0;
+    auto sink = source | carl::map([](int value) { return value + 1; })
+                | carl::for_each([&total](int value) { total += value; });
+
+    const std::size_t before = allocation_count.load();
+    for (int i = 0; i < 6; ++i) {
+        source.emit(i);
+    }
+    EXPECT_EQ(allocation_count.load() - before, std::size_t{0});
+    EXPECT_EQ(seen == std::vector<double>({0.0, 3.0, 6.0}), true);
+    EXPECT_EQ(total, 21LL);
+
+    sink.unsubscribe();
+    source.emit(100);
+    EXPECT_EQ(total, 21LL);
+
+    carl::Scheduler scheduler(2);
+    std::atomic<int> async_sum{0};
+    auto async_out = source | carl::map([](int value) { return value * 10; }) | carl::to_stream(scheduler);
+    auto async_sub = async_out.subscribe([&async_sum](const int& value) { async_sum.fetch_add(value); });
+    source.emit(4);
+    scheduler.run();
+    EXPECT_EQ(async_sum.load(), 40);
+}
+
+void test_strand_preserves_event_order() {
+    carl::Scheduler scheduler(4);
+    carl::Stream<int> source;
+    auto shifted = carl::stream_map(scheduler, source, [](int value) { return value + 1; });
+    auto total = carl::stream_fold(scheduler, shifted, 0LL, [](long long sum, int value) { return sum + value; });
+
+    std::vector<int> order;
+    auto order_sub = shifted.subscribe([&order](const int& value) { order.push_back(value); });
+    long long last_total = -1;
+    int regressions = 0;
+    auto total_sub = total.subscribe([&](const long long& value) {
+        if (value <= last_total) {
+            ++regressions;
+        }
+        last_total = value;
+    });
+
+    for (int i = 0; i < 20000; ++i) {
+        source.emit(scheduler, i);
+    }
+    scheduler.run();
+
+    bool ordered = order.size() == 20000;
+    for (std::size_t i = 0; ordered && i < order.size(); ++i) {
+        ordered = order[i] == static_cast<int>(i) + 1;
+    }
+    EXPECT_EQ(ordered, true);
+    EXPECT_EQ(regressions, 0);
+    EXPECT_EQ(total.value(), 20000LL * 20001LL / 2LL);
+    EXPECT_EQ(last_total, 20000LL * 20001LL / 2LL);
+
+    auto strand = std::make_shared<carl::Strand>(scheduler);
+    std::vector<int> posted;
+    std::vector<std::jthread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&strand, &posted, p]() {
+            for (int i = 0; i < 1000; ++i) {
+                strand->post([&posted, p]() { posted.push_back(p); });
+            }
+        });
+    }
+    producers.clear();
+    scheduler.run();
+    EXPECT_EQ(posted.size(), std::size_t{4000});
+}
+
+void test_worker_affinity() {
+    const auto cpus = carl::parse_cpu_list("0-3,8,10-11\n");
+    EXPECT_EQ(cpus.size(), std::size_t{7});
+    EXPECT_EQ(cpus.back(), 11);
+    EXPECT_EQ(carl::parse_cpu_list("x,2").size(), std::size_t{1});
+
+    carl::Scheduler scheduler(carl::SchedulerOptions{.worker_count = 3, .cpus = {0}});
+    const auto& pinned = scheduler.worker_cpus(2);
+    EXPECT_EQ(pinned.empty() || (pinned.size() == 1 && pinned.front() == 0), true);
+    EXPECT_EQ(scheduler.current_worker().has_value(), false);
+
+    carl::Actor actor(scheduler, carl::ActorOptions{.batch_size = 4, .home = carl::WorkerGroup{2, 1}});
+    std::atomic<int> handled{0};
+    std::atomic<int> away{0};
+    scheduler.spawn(actor.run());
+    for (int i = 0; i < 200; ++i) {
+        actor.post([&]() {
+            if (scheduler.current_worker() != std::optional<std::size_t>{2}) {
+                away.fetch_add(1);
+            }
+            handled.fetch_add(1);
+        });
+    }
+    scheduler.run();
+    EXPECT_EQ(handled.load(), 200);
+    EXPECT_EQ(away.load(), 0);
+
+    std::atomic<int> on_worker_one{0};
+    for (int i = 0; i < 50; ++i) {
+        scheduler.submit_on(1, [&]() {
+            if (scheduler.current_worker() == std::optional<std::size_t>{1}) {
+                on_worker_one.fetch_add(1);
+            }
+        });
+    }
+    actor.stop();
+    scheduler.run();
+    EXPECT_EQ(on_worker_one.load(), 50);
+    EXPECT_EQ(scheduler.empty(), true);
+
+    carl::Scheduler numa(carl::SchedulerOptions{.worker_count = 2, .numa_nodes = {0}, .lifo_slot = true});
+    EXPECT_EQ(numa.numa_group(0).count, std::size_t{2});
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 8; ++i) {
+        numa.spawn(fan_out(numa, counter, 1000));
+    }
+    numa.run();
+    EXPECT_EQ(counter.load(), 8 * 1001);
+    EXPECT_EQ(numa.empty(), true);
+}
+
+void test_idle_strategies() {
+    for (auto idle : {carl::IdleStrategy::spin, carl::IdleStrategy::spin_yield, carl::IdleStrategy::spin_park}) {
+        carl::Scheduler scheduler(carl::SchedulerOptions{.worker_count = 2, .idle = idle, .spin_iterations = 16});
+        std::atomic<int> counter{0};
+        for (int i = 0; i < 4; ++i) {
+            scheduler.spawn(fan_out(scheduler, counter, 500));
+        }
+        scheduler.run();
+        EXPECT_EQ(counter.load(), 4 * 501);
+
+        std::atomic<long long> elapsed_ms{-1};
+        scheduler.spawn(sleep_then_record(scheduler, elapsed_ms));
+        scheduler.run();
+        EXPECT_EQ(elapsed_ms.load() >= 20, true);
+
+        TestActor actor(scheduler);
+        std::atomic<int> handled{0};
+        scheduler.spawn(actor.run());
+        for (int i = 0; i < 1000; ++i) {
+            actor.post([&handled]() { handled.fetch_add(1); });
+        }
+        scheduler.run();
+        EXPECT_EQ(handled.load(), 1000);
+        actor.stop();
+        scheduler.run();
+        EXPECT_EQ(scheduler.empty(), true);
+    }
+}
+
+void test_scheduler_stats() {
+    carl::Scheduler scheduler(2);
+    carl::Stream<int> stream;
+    int seen = 0;
+    auto subscription = stream.subscribe([&seen](const int&) { ++seen; });
+    TestActor actor(scheduler);
+    scheduler.spawn(actor.run());
+    for (int i = 0; i < 10; ++i) {
+        actor.post([&stream, i]() { stream.emit(i); });
+    }
+    scheduler.run();
+    EXPECT_EQ(seen, 10);
+
+    const auto stats = scheduler.stats();
+    EXPECT_EQ(stats.workers.size(), std::size_t{2});
+    EXPECT_EQ(stats.outstanding, std::size_t{0});
+    EXPECT_EQ(stats.injected, std::size_t{0});
+
+    const std::string text = carl::metrics::to_prometheus(stats);
+    EXPECT_EQ(text.find("# TYPE carl_worker_tasks_run_total counter") != std::string::npos, true);
+    EXPECT_EQ(text.find("carl_worker_queue_length{worker=\"1\"} 0") != std::string::npos, true);
+    const std::string json = carl::metrics::to_json(stats);
+    EXPECT_EQ(json.find("\"workers\":[{\"index\":0") != std::string::npos, true);
+
+    if constexpr (carl::metrics::enabled) {
+        std::uint64_t tasks = 0;
+        for (const auto& worker : stats.workers) {
+            tasks += worker.tasks_run;
+        }
+        EXPECT_EQ(tasks >= 1, true);
+        const auto node = std::find_if(stats.nodes.begin(), stats.nodes.end(), [](const auto& entry) {
+            return entry.kind == "stream" && entry.emits == 10;
+        });
+        EXPECT_EQ(node != stats.nodes.end() && node->observers == 1 && node->callback_time.count == 10, true);
+        EXPECT_EQ(stats.actors.size(), std::size_t{1});
+        EXPECT_EQ(stats.actors.front().messages, std::uint64_t{10});
+        EXPECT_EQ(stats.actors.front().mailbox_depth, std::int64_t{0});
+        EXPECT_EQ(stats.actors.front().queue_latency.count, std::uint64_t{10});
+        EXPECT_EQ(text.find("carl_actor_handler_seconds_count") != std::string::npos, true);
+    } else {
+        EXPECT_EQ(stats.nodes.empty() && stats.actors.empty(), true);
+    }
+
+    actor.stop();
+    scheduler.run();
+}
+
+void test_event_tracing() {
+    auto& tracer = carl::trace::Tracer::global();
+    tracer.clear();
+    tracer.start();
+    {
+        carl::Scheduler scheduler(2);
+        carl::Stream<int> source;
+        auto doubled = carl::stream_map(scheduler, source, [](int value) { return value * 2; });
+        TestActor actor(scheduler);
+        std::atomic<int> handled{0};
+        auto subscription = actor.subscribe(doubled, [&handled](const int&) { handled.fetch_add(1); });
+        scheduler.spawn(actor.run());
+        actor.emit(source, 21);
+        scheduler.run();
+        EXPECT_EQ(handled.load(), 1);
+        // The stop message is never handled, so it stays out of the trace.
+        tracer.stop();
+        actor.stop();
+        scheduler.run();
+    }
+
+    const std::string json = tracer.to_chrome_json();
+    EXPECT_EQ(json.find("\"traceEvents\":[") != std::string::npos, true);
+    if constexpr (carl::trace::enabled) {
+        EXPECT_EQ(json.find("\"name\":\"mailbox.handle\"") != std::string::npos, true);
+        EXPECT_EQ(json.find("\"name\":\"stream.dispatch\"") != std::string::npos, true);
+        // Every hop that was handed off is closed by the slice that ran it.
+        const auto count = [&json](const std::string& needle) {
+            std::size_t found = 0;
+            for (auto at = json.find(needle); at != std::string::npos; at = json.find(needle, at + 1)) {
+                ++found;
+            }
+            return found;
+        };
+        EXPECT_EQ(count("\"ph\":\"s\"") >= 4, true);
+        EXPECT_EQ(count("\"ph\":\"s\""), count("\"ph\":\"f\""));
+        EXPECT_EQ(count("\"ph\":\"B\""), count("\"ph\":\"E\""));
+    } else {
+        EXPECT_EQ(json.find("\"ph\"") == std::string::npos, true);
+    }
+    tracer.clear();
+}
+
+void test_graph_registry() {
+    carl::Scheduler scheduler(1);
+    {
+        carl::ReactiveContext plain(scheduler);
+        EXPECT_EQ(plain.graph() == nullptr, true);
+    }
+
+    carl::ReactiveContext context(scheduler, carl::ReactiveContextOptions{.record_graph = true});
+    auto price = context.signal(10);
+    context.name(price, "price");
+    auto doubled = context.signal_map(price, [](int value) { return value * 2; });
+    auto next = context.signal_map(price, [](int value) { return value + 1; });
+    auto total = context.signal_combine(doubled, next, [](int left, int right) { return left + right; });
+    auto label = context.signal_map(total, [](int value) { return std::to_string(value); });
+    context.name(label, "label");
+    auto ticks = context.stream<int>();
+    auto evens = context.stream_filter(ticks, [](int value) { return value % 2 == 0; });
+
+    const carl::GraphRegistry& graph = *context.graph();
+    EXPECT_EQ(graph.nodes().size(), static_cast<std::size_t>(7));
+    EXPECT_EQ(graph.fan_out(price.id()), static_cast<std::size_t>(4));
+    EXPECT_EQ(graph.fan_out(ticks.id()), static_cast<std::size_t>(1));
+    EXPECT_EQ(graph.fan_out(label.id()), static_cast<std::size_t>(0));
+
+    const auto path = graph.critical_path();
+    EXPECT_EQ(path.size(), static_cast<std::size_t>(4));
+    EXPECT_EQ(path.front() == price.id(), true);
+    EXPECT_EQ(path.back() == label.id(), true);
+
+    const std::string dot = graph.to_dot();
+    EXPECT_EQ(dot.starts_with("digraph carl {"), true);
+    EXPECT_EQ(dot.find("\"price\\nsource") != std::string::npos, true);
+    EXPECT_EQ(dot.find("\"label\\nsignal_map") != std::string::npos, true);
+    EXPECT_EQ(dot.find("n0 -> n1;") != std::string::npos, true);
+
+    const std::string json = graph.to_json();
+    EXPECT_EQ(json.find("\"op\":\"signal_combine\"") != std::string::npos, true);
+    EXPECT_EQ(json.find("\"op\":\"stream_filter\"") != std::string::npos, true);
+    EXPECT_EQ(json.find("\"from\":\"n5\",\"to\":\"n6\"") != std::string::npos, true);
+
+    // Entries only observe their nodes; ones that are gone drop out.
+    {
+        auto scratch = context.signal(1);
+        auto negated = context.signal_map(scratch, [](int value) { return -value; });
+        EXPECT_EQ(graph.nodes().size(), static_cast<std::size_t>(9));
+    }
+    EXPECT_EQ(graph.nodes().size(), static_cast<std::size_t>(7));
+
+    // A node allocated where a dead one lived does not inherit its edges.
+    for (int i = 0; i < 200; ++i) {
+        auto scratch = context.signal(i);
+        auto negated = context.signal_map(scratch, [](int value) { return -value; });
+    }
+    std::optional<carl::Signal<int>> orphan;
+    {
+        auto scratch = context.signal(1);
+        orphan = context.signal_map(scratch, [](int value) { return -value; });
+    }
+    auto fresh = context.signal(2);
+    auto fresh_doubled = context.signal_map(fresh, [](int value) { return value * 2; });
+    EXPECT_EQ(graph.nodes().size(), static_cast<std::size_t>(10));
+    EXPECT_EQ(graph.fan_out(fresh.id()), static_cast<std::size_t>(1));
+    EXPECT_EQ(graph.fan_out(price.id()), static_cast<std::size_t>(4));
+    std::size_t edges = 0;
+    for (const auto& node : graph.nodes()) {
+        edges += node.inputs.size();
+    }
+    EXPECT_EQ(edges, static_cast<std::size_t>(7));
+    EXPECT_EQ(evens.id() != nullptr, true);
+}
+
+void test_shared_payload_delivery() {
+    carl::Scheduler scheduler(2);
+    carl::Stream<std::vector<std::uint8_t>> frames;
+    auto shared = carl::stream_share(frames);
+
+    // Every actor sees the one copy made by stream_share.
+    std::mutex mutex;
+    std::vector<const std::uint8_t*> seen;
+    std::vector<std::unique_ptr<TestActor>> actors;
+    std::vector<carl::Subscription> subscriptions;
+    for (int i = 0; i < 4; ++i) {
+        actors.push_back(std::make_unique<TestActor>(scheduler));
+        subscriptions.push_back(actors.back()->subscribe(shared, [&](const std::vector<std::uint8_t>& frame) {
+            std::lock_guard<std::mutex> lock(mutex);
+            seen.push_back(frame.data());
+        }));
+        scheduler.spawn(actors.back()->run());
+    }
+    frames.emit(std::vector<std::uint8_t>(65536, 7));
+    scheduler.run();
+    EXPECT_EQ(seen.size(), static_cast<std::size_t>(4));
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), seen.front()), static_cast<std::ptrdiff_t>(4));
+
+    // A Payload emitted directly is never copied, also through scheduled dispatch.
+    carl::Stream<carl::Payload<std::vector<std::uint8_t>>> direct;
+    auto sizes =
+        carl::stream_map(scheduler, direct, [](const std::vector<std::uint8_t>& frame) { return frame.size(); });
+    const auto frame = carl::make_payload<std::vector<std::uint8_t>>(1024, 1);
+    const std::uint8_t* delivered = nullptr;
+    auto subscription =
+        direct.subscribe([&delivered](const std::vector<std::uint8_t>& value) { delivered = value.data(); });
+    std::atomic<std::size_t> size{0};
+    auto size_subscription = sizes.subscribe([&size](std::size_t value) { size.store(value); });
+    direct.emit(scheduler, frame);
+    scheduler.run();
+    EXPECT_EQ(delivered == frame->data(), true);
+    EXPECT_EQ(size.load(), static_cast<std::size_t>(1024));
+
+    for (auto& actor : actors) {
+        actor->stop();
+    }
+    scheduler.run();
+}
+
+void test_signal_value_ref() {
+    static_assert(!carl::Signal<int>::shares_value);
+    static_assert(carl::Signal<std::string>::shares_value);
+
+    carl::Signal<std::string> name(std::string(100, 'a'));
+    const auto first = name.value_ref();
+    const auto again = name.value_ref();
+    EXPECT_EQ(&*first == &*again, true);
+    EXPECT_EQ(name.read([](const std::string& value) { return value.size(); }), static_cast<std::size_t>(100));
+
+    // A handle keeps the value it was taken from; observers share the new one.
+    const std::string* observed = nullptr;
+    auto subscription = name.subscribe([&observed](const std::string& value) { observed = &value; });
+    name.set("b");
+    EXPECT_EQ(*first, std::string(100, 'a'));
+    EXPECT_EQ(observed == &*name.value_ref(), true);
+    EXPECT_EQ(name.value(), std::string("b"));
+
+    // read() runs outside the signal's lock, so it may set the signal.
+    carl::Signal<int> counter(1);
+    counter.read([&counter](int value) { counter.set(value + 1); });
+    EXPECT_EQ(counter.value(), 2);
+
+    // Lazy nodes are recomputed before they are read.
+    auto upper = carl::signal_map_lazy(name, [](const std::string& value) { return value + "!"; });
+    name.set("c");
+    EXPECT_EQ(upper.read([](const std::string& value) { return value; }), std::string("c!"));
+}
+
+void test_versioned_signal_reads() {
+    // Versions move on every stored change and nothing else.
+    carl::Signal<int> left(1);
+    EXPECT_EQ(left.version(), static_cast<std::uint64_t>(0));
+    left.set(2);
+    left.set(2);
+    EXPECT_EQ(left.version(), static_cast<std::uint64_t>(1));
+    carl::Signal<std::string> text("a");
+    text.set("b");
+    EXPECT_EQ(text.version(), static_cast<std::uint64_t>(1));
+
+    // Readers never see a torn value while a writer keeps storing.
+    struct Pair {
+        std::uint64_t first{0};
+        std::uint64_t second{0};
+    };
+    carl::Signal<Pair> pair(Pair{}, carl::always_notify);
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::thread reader([&]() {
+        while (!done.load()) {
+            const Pair value = pair.value();
+            torn.fetch_add(value.first == value.second ? 0 : 1);
+        }
+    });
+    for (std::uint64_t i = 1; i <= 100000; ++i) {
+        pair.set(Pair{i, i});
+    }
+    done.store(true);
+    reader.join();
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(pair.version(), static_cast<std::uint64_t>(100000));
+
+    // A scheduled notification that finds both inputs where the previous
+    // recomputation saw them is skipped.
+    carl::Scheduler scheduler(1);
+    carl::Signal<int> right(10);
+    std::atomic<int> computed{0};
+    auto sum = carl::signal_combine(scheduler, left, right, [&computed](int a, int b) {
+        computed.fetch_add(1);
+        return a + b;
+    });
+    EXPECT_EQ(computed.load(), 1);
+    scheduler.submit([&]() {
+        left.set(scheduler, 3);
+        left.set(scheduler, 4);
+        right.set(scheduler, 20);
+    });
+    scheduler.run();
+    EXPECT_EQ(sum.value(), 24);
+    EXPECT_EQ(computed.load(), 2);
+
+    // Reading a dirty lazy node only moves its version if the value changed.
+    carl::Signal<int> base(2);
+    auto parity = carl::signal_map_lazy(base, [](int value) { return value % 2; });
+    const std::uint64_t initial = parity.version();
+    base.set(4);
+    EXPECT_EQ(parity.dirty(), true);
+    EXPECT_EQ(parity.value(), 0);
+    EXPECT_EQ(parity.version(), initial);
+    base.set(5);
+    EXPECT_EQ(parity.value(), 1);
+    EXPECT_EQ(parity.version(), initial + 1);
+}
+
+void test_work_stealing_scheduler() {
+    carl::Scheduler scheduler(4);
+    std::atomic<int> counter{0};
+
+    for (int i = 0; i < 8; ++i) {
+        scheduler.spawn(fan_out(scheduler, counter, 1000));
+    }
+    scheduler.run();
+
+    EXPECT_EQ(counter.load(), 8 * 1001);
+    EXPECT_EQ(scheduler.empty(), true);
+}
+
 }  // namespace
 
 int main() {
@@ -118,6 +1405,37 @@ int main() {
     test_stream_fold();
     test_multi_node_chain();
     test_actor_message_loop();
+    test_actor_stop_runs_on_stop();
+    test_work_stealing_scheduler();
+    test_actor_parks_when_idle();
+    test_actor_park_wake_cycles();
+    test_mailbox_drain();
+    test_actor_batch_contention();
+    test_inline_function();
+    test_actor_messages_allocation_free();
+    test_pooled_frames_and_jobs();
+    test_emit_uses_observer_snapshot();
+    test_actor_subscription_allocation_free();
+    test_subscription_churn_compacts();
+    test_glitch_free_diamond();
+    test_transaction_batches_updates();
+    test_signal_change_suppression();
+    test_lazy_signal_nodes();
+    test_bounded_subscriptions();
+    test_timer_wheel();
+    test_time_operators();
+    test_stream_emit_batch();
+    test_simd_stream_operators();
+    test_fused_pipeline();
+    test_strand_preserves_event_order();
+    test_worker_affinity();
+    test_idle_strategies();
+    test_scheduler_stats();
+    test_event_tracing();
+    test_graph_registry();
+    test_shared_payload_delivery();
+    test_signal_value_ref();
+    test_versioned_signal_reads();
 
     if (failures == 0) {
         std::cout << "All tests passed.\n";